@@ -0,0 +1,382 @@
+#include "bench.h"
+#include "perf_counters.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+static std::atomic<size_t> allocatedBytes{ 0 };
+
+void* operator new(size_t size)
+{
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+    if (void* p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+
+    throw std::bad_alloc{};
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+static void* AlignedAlloc(size_t alignment, size_t size)
+{
+#if defined(_MSC_VER)
+    return _aligned_malloc(size, alignment);
+#else
+    return std::aligned_alloc(alignment, size);
+#endif
+}
+
+static void AlignedFree(void* p)
+{
+#if defined(_MSC_VER)
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+    // aligned_alloc requires the size to be a multiple of the alignment
+    size_t align = size_t(alignment);
+    if (void* p = AlignedAlloc(align, (size + align - 1) / align * align))
+    {
+        return p;
+    }
+
+    throw std::bad_alloc{};
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+    AlignedFree(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept
+{
+    AlignedFree(p);
+}
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept
+{
+    AlignedFree(p);
+}
+
+void operator delete[](void* p, size_t, std::align_val_t) noexcept
+{
+    AlignedFree(p);
+}
+
+namespace bench
+{
+
+size_t GetAllocatedBytes()
+{
+    return allocatedBytes.load(std::memory_order_relaxed);
+}
+
+Runner::Runner(const Options& options)
+    : options{ options }
+{
+    if (options.perfCounters)
+    {
+        perfCounters = std::make_unique<PerfCounters>();
+
+        if (!perfCounters->IsAvailable())
+        {
+            std::printf("Hardware counters unavailable (%s), continuing without them\n", perfCounters->GetError().c_str());
+            perfCounters.reset();
+        }
+        else if (!perfCounters->GetError().empty())
+        {
+            std::printf("Some hardware counters unavailable (%s)\n", perfCounters->GetError().c_str());
+        }
+    }
+}
+
+Runner::~Runner() noexcept = default;
+
+void Runner::Run(const std::string& name, size_t size, size_t opsPerIteration, const std::function<void(size_t)>& body)
+{
+    using Clock = std::chrono::steady_clock;
+
+    lastRunEnabled = IsEnabled(name);
+
+    if (!lastRunEnabled)
+    {
+        return;
+    }
+
+    // Warm up caches and trigger lazy growth before measuring
+    body(1);
+
+    size_t iterations = 1;
+    double seconds = 0.0;
+    size_t bytes = 0;
+
+    while (true)
+    {
+        if (perfCounters)
+        {
+            perfCounters->Start();
+        }
+
+        size_t bytesBefore = GetAllocatedBytes();
+        Clock::time_point begin = Clock::now();
+
+        body(iterations);
+
+        Clock::time_point end = Clock::now();
+
+        if (perfCounters)
+        {
+            perfCounters->Stop();
+        }
+
+        seconds = std::chrono::duration<double>(end - begin).count();
+        bytes = GetAllocatedBytes() - bytesBefore;
+
+        if (seconds >= options.minTime || iterations >= (size_t(1) << 40))
+        {
+            break;
+        }
+
+        // Aim slightly past the minimum time, growing at most 10x per attempt
+        double scale = seconds > 0.0 ? options.minTime * 1.4 / seconds : 10.0;
+        scale = scale > 10.0 ? 10.0 : scale;
+        size_t next = size_t(double(iterations) * scale);
+        iterations = next > iterations ? next : iterations + 1;
+    }
+
+    double ops = double(iterations) * double(opsPerIteration);
+
+    Result result;
+    result.name = name;
+    result.size = size;
+    result.iterations = iterations;
+    result.nsPerOp = seconds * 1e9 / ops;
+    result.opsPerSecond = ops / seconds;
+    result.bytesAllocatedPerOp = double(bytes) / ops;
+
+    if (perfCounters)
+    {
+        for (auto& [counter, value] : perfCounters->Read())
+        {
+            result.countersPerOp.emplace_back(counter, value / ops);
+        }
+    }
+
+    std::printf("%-48s %14.2f ns/op %14.3f Mop/s %14.1f B/op", name.c_str(), result.nsPerOp, result.opsPerSecond * 1e-6,
+                result.bytesAllocatedPerOp);
+
+    for (auto& [counter, value] : result.countersPerOp)
+    {
+        std::printf("  %s=%.3f", counter.c_str(), value);
+    }
+
+    std::printf("\n");
+    std::fflush(stdout);
+
+    results.push_back(result);
+}
+
+void Runner::AddMetric(const std::string& key, double value)
+{
+    if (!lastRunEnabled)
+    {
+        return;
+    }
+
+    results.back().metrics.emplace_back(key, value);
+    std::printf("%-48s %s=%.3f\n", "", key.c_str(), value);
+}
+
+bool Runner::IsEnabled(const std::string& name) const
+{
+    return options.filter.empty() || name.find(options.filter) != std::string::npos;
+}
+
+const Options& Runner::GetOptions() const
+{
+    return options;
+}
+
+const std::vector<Result>& Runner::GetResults() const
+{
+    return results;
+}
+
+// Field names follow the Google Benchmark JSON format so existing comparison tools can read the report
+void Runner::WriteJson(const std::string& path) const
+{
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (file == nullptr)
+    {
+        std::fprintf(stderr, "Failed to open %s\n", path.c_str());
+        return;
+    }
+
+    std::fprintf(file, "{\n");
+    std::fprintf(file, "  \"context\": {\n");
+    std::fprintf(file, "    \"max_size\": %zu,\n", options.maxSize);
+    std::fprintf(file, "    \"min_time\": %g\n", options.minTime);
+    std::fprintf(file, "  },\n");
+    std::fprintf(file, "  \"benchmarks\": [\n");
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const Result& result = results[i];
+
+        std::fprintf(file, "    {\n");
+        std::fprintf(file, "      \"name\": \"%s\",\n", result.name.c_str());
+        std::fprintf(file, "      \"size\": %zu,\n", result.size);
+        std::fprintf(file, "      \"iterations\": %zu,\n", result.iterations);
+        std::fprintf(file, "      \"real_time\": %.4f,\n", result.nsPerOp);
+        std::fprintf(file, "      \"time_unit\": \"ns\",\n");
+        std::fprintf(file, "      \"items_per_second\": %.4f,\n", result.opsPerSecond);
+        std::fprintf(file, "      \"bytes_allocated_per_op\": %.4f", result.bytesAllocatedPerOp);
+
+        for (auto& [counter, value] : result.countersPerOp)
+        {
+            std::fprintf(file, ",\n      \"%s_per_op\": %.4f", counter.c_str(), value);
+        }
+
+        for (auto& [key, value] : result.metrics)
+        {
+            std::fprintf(file, ",\n      \"%s\": %.4f", key.c_str(), value);
+        }
+
+        std::fprintf(file, "\n");
+        std::fprintf(file, "    }%s\n", i + 1 < results.size() ? "," : "");
+    }
+
+    std::fprintf(file, "  ]\n");
+    std::fprintf(file, "}\n");
+
+    std::fclose(file);
+}
+
+Suite::Suite(const char* name, void (*runFcn)(Runner&))
+{
+    GetSuites().emplace_back(name, runFcn);
+}
+
+std::vector<std::pair<const char*, void (*)(Runner&)>>& GetSuites()
+{
+    static std::vector<std::pair<const char*, void (*)(Runner&)>> suites;
+    return suites;
+}
+
+std::vector<size_t> GetSizes(const Options& options)
+{
+    std::vector<size_t> sizes;
+    for (size_t n = size_t(1) << 10; n <= options.maxSize; n *= 32)
+    {
+        sizes.push_back(n);
+    }
+
+    return sizes;
+}
+
+} // namespace bench
+
+static void PrintUsage(const char* program)
+{
+    std::printf("Usage: %s [options]\n", program);
+    std::printf("  --max-size=N     largest element count, sizes grow 32x from 1024 (default 1048576, up to 1073741824)\n");
+    std::printf("  --min-time=S     minimum measured seconds per benchmark (default 0.2)\n");
+    std::printf("  --filter=TEXT    run only benchmarks whose name contains TEXT\n");
+    std::printf("  --json=PATH      write results as JSON to PATH\n");
+    std::printf("  --perf           read hardware performance counters (Linux perf_event_open)\n");
+}
+
+int main(int argc, char** argv)
+{
+    bench::Options options;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* arg = argv[i];
+
+        if (std::strncmp(arg, "--max-size=", 11) == 0)
+        {
+            options.maxSize = std::strtoull(arg + 11, nullptr, 10);
+        }
+        else if (std::strncmp(arg, "--min-time=", 11) == 0)
+        {
+            options.minTime = std::strtod(arg + 11, nullptr);
+        }
+        else if (std::strncmp(arg, "--filter=", 9) == 0)
+        {
+            options.filter = arg + 9;
+        }
+        else if (std::strncmp(arg, "--json=", 7) == 0)
+        {
+            options.jsonPath = arg + 7;
+        }
+        else if (std::strcmp(arg, "--perf") == 0)
+        {
+            options.perfCounters = true;
+        }
+        else
+        {
+            PrintUsage(argv[0]);
+            return std::strcmp(arg, "--help") == 0 ? 0 : 1;
+        }
+    }
+
+#if !defined(NDEBUG)
+    std::printf("Warning: benchmarks were built without NDEBUG, timings include assertions\n");
+#endif
+
+    bench::Runner runner{ options };
+
+    for (auto& [name, runFcn] : bench::GetSuites())
+    {
+        std::printf("== %s ==\n", name);
+        runFcn(runner);
+    }
+
+    if (!options.jsonPath.empty())
+    {
+        runner.WriteJson(options.jsonPath);
+    }
+
+    return 0;
+}
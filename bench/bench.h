@@ -0,0 +1,133 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Minimal self-contained benchmark harness
+// Each benchmark body receives an iteration count and must perform that many iterations,
+// the runner grows the count until the measurement lasts at least the minimum time.
+namespace bench
+{
+
+struct Options
+{
+    // Largest element count to benchmark, sizes are swept geometrically up to this
+    size_t maxSize = size_t(1) << 20;
+
+    // Minimum measured time per benchmark in seconds
+    double minTime = 0.2;
+
+    // Only benchmarks whose name contains this string are run
+    std::string filter;
+
+    // Path of the JSON report, empty for none
+    std::string jsonPath;
+
+    // Read hardware performance counters around every measurement
+    bool perfCounters = false;
+};
+
+struct Result
+{
+    std::string name;
+    size_t size;
+    size_t iterations;
+    double nsPerOp;
+    double opsPerSecond;
+    double bytesAllocatedPerOp;
+
+    // Hardware counter values per op, empty unless perf counters are enabled and available
+    std::vector<std::pair<std::string, double>> countersPerOp;
+
+    // Additional named values attached by the benchmark itself
+    std::vector<std::pair<std::string, double>> metrics;
+};
+
+// Total bytes requested from the global operator new since startup
+size_t GetAllocatedBytes();
+
+class PerfCounters;
+
+class Runner
+{
+public:
+    explicit Runner(const Options& options);
+    ~Runner() noexcept;
+
+    // Runs body(iterations), where every iteration performs opsPerIteration operations on a structure of size elements
+    void Run(const std::string& name, size_t size, size_t opsPerIteration, const std::function<void(size_t)>& body);
+
+    // Attaches a named value to the result of the most recent Run, ignored when that Run was filtered out
+    void AddMetric(const std::string& key, double value);
+
+    bool IsEnabled(const std::string& name) const;
+    const Options& GetOptions() const;
+    const std::vector<Result>& GetResults() const;
+
+    void WriteJson(const std::string& path) const;
+
+private:
+    Options options;
+    std::vector<Result> results;
+    std::unique_ptr<PerfCounters> perfCounters;
+
+    // Whether the most recent Run passed the filter and added a result
+    bool lastRunEnabled = false;
+};
+
+// A named group of benchmarks, registered at static initialization time
+struct Suite
+{
+    Suite(const char* name, void (*runFcn)(Runner&));
+};
+
+std::vector<std::pair<const char*, void (*)(Runner&)>>& GetSuites();
+
+// Element counts from 1K growing by 32x up to the configured maximum
+std::vector<size_t> GetSizes(const Options& options);
+
+// Keeps the compiler from discarding a computed value
+template <typename T>
+inline void DoNotOptimize(const T& value)
+{
+#if defined(_MSC_VER)
+    const volatile void* sink = &value;
+    (void)sink;
+#else
+    asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+// Small deterministic generator so runs are reproducible across platforms
+class Random
+{
+public:
+    explicit Random(uint64_t seed)
+        : state{ seed }
+    {
+    }
+
+    uint64_t Next()
+    {
+        state += 0x9E3779B97F4A7C15ull;
+        uint64_t z = state;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    size_t Below(size_t bound)
+    {
+        return size_t(Next() % bound);
+    }
+
+private:
+    uint64_t state;
+};
+
+} // namespace bench
@@ -0,0 +1,86 @@
+#include "bench.h"
+#include "segment_tree/blocked_segment_tree.h"
+#include "segment_tree/segment_tree.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+int64_t Add(int64_t a, int64_t b)
+{
+    return a + b;
+}
+
+constexpr size_t operandCount = 4096;
+
+struct Operands
+{
+    std::vector<size_t> lefts;
+    std::vector<size_t> rights;
+};
+
+template <typename Tree>
+void RunTree(bench::Runner& runner, const std::string& name, size_t n, Tree& tree, const Operands& operands)
+{
+    runner.Run("Blocked/query/" + name + "/" + std::to_string(n), n, 1, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            bench::DoNotOptimize(tree.Query(operands.lefts[k % operandCount], operands.rights[k % operandCount]));
+        }
+    });
+
+    runner.AddMetric("tree-bytes", double(tree.GetAllocatedBytes()));
+
+    runner.Run("Blocked/update/" + name + "/" + std::to_string(n), n, 1, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            tree.Update(operands.lefts[k % operandCount], int64_t(k));
+        }
+        bench::DoNotOptimize(tree.GetTree()[1]);
+    });
+}
+
+// SegmentTree against bucket trees of 32 and 64 elements, the tree array size is attached as a metric
+void RunBlocked(bench::Runner& runner, size_t n)
+{
+    std::vector<int64_t> data(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        data[i] = int64_t(i * 7919 % 1000);
+    }
+
+    bench::Random random{ n };
+
+    Operands operands{ std::vector<size_t>(operandCount), std::vector<size_t>(operandCount) };
+    for (size_t i = 0; i < operandCount; ++i)
+    {
+        size_t a = random.Below(n);
+        size_t b = random.Below(n);
+        operands.lefts[i] = a < b ? a : b;
+        operands.rights[i] = (a < b ? b : a) + 1;
+    }
+
+    SegmentTree<int64_t> tree{ data, Add, 0 };
+    RunTree(runner, "segment-tree", n, tree, operands);
+
+    BlockedSegmentTree<int64_t, 32, std::plus<>> blocked32{ data, 0 };
+    RunTree(runner, "blocked-32", n, blocked32, operands);
+
+    BlockedSegmentTree<int64_t, 64, std::plus<>> blocked64{ data, 0 };
+    RunTree(runner, "blocked-64", n, blocked64, operands);
+}
+
+void Run(bench::Runner& runner)
+{
+    for (size_t n : bench::GetSizes(runner.GetOptions()))
+    {
+        RunBlocked(runner, n);
+    }
+}
+
+bench::Suite suite{ "Blocked", Run };
+
+} // namespace
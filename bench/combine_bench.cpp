@@ -0,0 +1,106 @@
+#include "bench.h"
+#include "segment_tree/segment_tree.h"
+
+#include <string>
+#include <vector>
+
+namespace
+{
+
+// 512-byte aggregate, e.g. a histogram of 64 bins
+struct Histogram
+{
+    int64_t bins[64];
+};
+
+Histogram Add(Histogram a, Histogram b)
+{
+    Histogram result;
+    for (int i = 0; i < 64; ++i)
+    {
+        result.bins[i] = a.bins[i] + b.bins[i];
+    }
+
+    return result;
+}
+
+void AddInto(Histogram& out, const Histogram& a, const Histogram& b)
+{
+    for (int i = 0; i < 64; ++i)
+    {
+        out.bins[i] = a.bins[i] + b.bins[i];
+    }
+}
+
+constexpr size_t operandCount = 4096;
+
+// Combine by value copies both operands in and the result out on every step, combine into works in place
+template <typename F>
+void RunCombine(bench::Runner& runner, size_t n, const char* variant, F combineFcn)
+{
+    std::vector<Histogram> data(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        for (int j = 0; j < 64; ++j)
+        {
+            data[i].bins[j] = int64_t((i * 64 + j) % 1000);
+        }
+    }
+
+    std::string suffix = std::string{ "/" } + variant + "/" + std::to_string(n);
+
+    runner.Run("Combine/construct" + suffix, n, n, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            SegmentTree<Histogram> tree{ data, combineFcn, Histogram{} };
+            bench::DoNotOptimize(tree.GetTree()[1]);
+        }
+    });
+
+    SegmentTree<Histogram> tree{ data, combineFcn, Histogram{} };
+
+    bench::Random random{ n };
+
+    std::vector<size_t> lefts(operandCount);
+    std::vector<size_t> rights(operandCount);
+    for (size_t i = 0; i < operandCount; ++i)
+    {
+        size_t a = random.Below(n);
+        size_t b = random.Below(n);
+        lefts[i] = a < b ? a : b;
+        rights[i] = (a < b ? b : a) + 1;
+    }
+
+    runner.Run("Combine/update" + suffix, n, 1, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            tree.Update(lefts[k % operandCount], data[k % n]);
+        }
+    });
+
+    runner.Run("Combine/query" + suffix, n, 1, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            bench::DoNotOptimize(tree.Query(lefts[k % operandCount], rights[k % operandCount]));
+        }
+    });
+}
+
+void Run(bench::Runner& runner)
+{
+    // The trees hold 1KB per element, so stop an order of magnitude earlier than the other suites
+    for (size_t n : bench::GetSizes(runner.GetOptions()))
+    {
+        if (n > runner.GetOptions().maxSize / 32)
+        {
+            break;
+        }
+
+        RunCombine(runner, n, "value", Add);
+        RunCombine(runner, n, "into", AddInto);
+    }
+}
+
+bench::Suite suite{ "Combine", Run };
+
+} // namespace
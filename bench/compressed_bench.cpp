@@ -0,0 +1,89 @@
+#include "bench.h"
+#include "segment_tree/compressed_sum_tree.h"
+#include "segment_tree/segment_tree.h"
+
+#include <string>
+#include <vector>
+
+namespace
+{
+
+uint64_t Add(uint64_t a, uint64_t b)
+{
+    return a + b;
+}
+
+constexpr size_t operandCount = 4096;
+
+// Byte counts summed by a compressed tree and by SegmentTree<uint64_t>, the memory used is attached as a metric
+void RunCompressed(bench::Runner& runner, size_t n)
+{
+    std::vector<uint64_t> data(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        data[i] = i * 7919 % 256;
+    }
+
+    bench::Random random{ n };
+
+    std::vector<size_t> lefts(operandCount);
+    std::vector<size_t> rights(operandCount);
+    for (size_t i = 0; i < operandCount; ++i)
+    {
+        size_t a = random.Below(n);
+        size_t b = random.Below(n);
+        lefts[i] = a < b ? a : b;
+        rights[i] = (a < b ? b : a) + 1;
+    }
+
+    std::string suffix = "/" + std::to_string(n);
+
+    SegmentTree<uint64_t> tree{ data, Add, 0 };
+    CompressedSumTree compressed{ data, 255 };
+
+    runner.Run("Compressed/query/segment-tree" + suffix, n, 1, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            bench::DoNotOptimize(tree.Query(lefts[k % operandCount], rights[k % operandCount]));
+        }
+    });
+
+    runner.AddMetric("bytes", double(tree.GetAllocatedBytes()));
+
+    runner.Run("Compressed/query/compressed" + suffix, n, 1, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            bench::DoNotOptimize(compressed.Query(lefts[k % operandCount], rights[k % operandCount]));
+        }
+    });
+
+    runner.AddMetric("bytes", double(compressed.GetMemoryUsage()));
+
+    runner.Run("Compressed/update/segment-tree" + suffix, n, 1, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            tree.Update(lefts[k % operandCount], k % 256);
+        }
+        bench::DoNotOptimize(tree.GetTree()[1]);
+    });
+
+    runner.Run("Compressed/update/compressed" + suffix, n, 1, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            compressed.Update(lefts[k % operandCount], k % 256);
+        }
+        bench::DoNotOptimize(compressed[0]);
+    });
+}
+
+void Run(bench::Runner& runner)
+{
+    for (size_t n : bench::GetSizes(runner.GetOptions()))
+    {
+        RunCompressed(runner, n);
+    }
+}
+
+bench::Suite suite{ "Compressed", Run };
+
+} // namespace
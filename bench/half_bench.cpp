@@ -0,0 +1,139 @@
+#include "bench.h"
+#include "segment_tree/half_segment_tree.h"
+#include "segment_tree/segment_tree.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+int64_t Add(int64_t a, int64_t b)
+{
+    return a + b;
+}
+
+constexpr size_t operandCount = 4096;
+
+// Full SegmentTree layout against the left-child-only layout, the tree array size is attached as a metric
+void RunHalf(bench::Runner& runner, size_t n)
+{
+    std::vector<int64_t> data(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        data[i] = int64_t(i * 7919 % 1000);
+    }
+
+    bench::Random random{ n };
+
+    std::vector<size_t> lefts(operandCount);
+    std::vector<size_t> rights(operandCount);
+    for (size_t i = 0; i < operandCount; ++i)
+    {
+        size_t a = random.Below(n);
+        size_t b = random.Below(n);
+        lefts[i] = a < b ? a : b;
+        rights[i] = (a < b ? b : a) + 1;
+    }
+
+    std::string suffix = "/" + std::to_string(n);
+
+    SegmentTree<int64_t> full{ data, Add, 0 };
+    HalfSegmentTree<int64_t, std::plus<>, std::minus<>> half{ data, 0 };
+
+    runner.Run("Half/query/full" + suffix, n, 1, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            bench::DoNotOptimize(full.Query(lefts[k % operandCount], rights[k % operandCount]));
+        }
+    });
+
+    runner.AddMetric("tree-bytes", double(full.GetAllocatedBytes()));
+
+    runner.Run("Half/query/half" + suffix, n, 1, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            bench::DoNotOptimize(half.Query(lefts[k % operandCount], rights[k % operandCount]));
+        }
+    });
+
+    runner.AddMetric("tree-bytes", double(half.GetCapacity() * sizeof(int64_t)));
+
+    runner.Run("Half/update/full" + suffix, n, 1, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            full.Update(lefts[k % operandCount], int64_t(k % 1000));
+        }
+        bench::DoNotOptimize(full.GetTree()[1]);
+    });
+
+    runner.Run("Half/update/half" + suffix, n, 1, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            half.Update(lefts[k % operandCount], int64_t(k % 1000));
+        }
+        bench::DoNotOptimize(half.GetTree()[0]);
+    });
+
+    runner.Run("Half/add/full" + suffix, n, 1, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            full.Add(lefts[k % operandCount], 1);
+        }
+        bench::DoNotOptimize(full.GetTree()[1]);
+    });
+
+    runner.Run("Half/add/half" + suffix, n, 1, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            half.Add(lefts[k % operandCount], 1);
+        }
+        bench::DoNotOptimize(half.GetTree()[0]);
+    });
+
+    int64_t total = half.PrefixQuery(n);
+
+    runner.Run("Half/lower-bound/half" + suffix, n, 1, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            bench::DoNotOptimize(half.LowerBound(int64_t(lefts[k % operandCount] % size_t(total + 1))));
+        }
+    });
+
+    runner.Run("Half/push-back/full" + suffix, n, n, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            SegmentTree<int64_t> tree{ {}, Add, 0 };
+            for (size_t i = 0; i < n; ++i)
+            {
+                tree.PushBack(data[i]);
+            }
+            bench::DoNotOptimize(tree.GetTree()[1]);
+        }
+    });
+
+    runner.Run("Half/push-back/half" + suffix, n, n, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            HalfSegmentTree<int64_t, std::plus<>, std::minus<>> tree{ std::span<const int64_t>{}, 0 };
+            for (size_t i = 0; i < n; ++i)
+            {
+                tree.PushBack(data[i]);
+            }
+            bench::DoNotOptimize(tree.GetTree()[0]);
+        }
+    });
+}
+
+void Run(bench::Runner& runner)
+{
+    for (size_t n : bench::GetSizes(runner.GetOptions()))
+    {
+        RunHalf(runner, n);
+    }
+}
+
+bench::Suite suite{ "Half", Run };
+
+} // namespace
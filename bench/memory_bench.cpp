@@ -0,0 +1,94 @@
+#include "bench.h"
+#include "segment_tree/segment_tree.h"
+
+#include <string>
+#include <vector>
+
+namespace
+{
+
+int64_t Add(int64_t a, int64_t b)
+{
+    return a + b;
+}
+
+constexpr size_t operandCount = 4096;
+
+const char* GetName(const MemoryOptions& memory)
+{
+    if (memory.numa == NumaPolicy::Interleave)
+    {
+        return memory.pages == PageMode::Default ? "interleave" : "thp-interleave";
+    }
+
+    switch (memory.pages)
+    {
+    case PageMode::Transparent:
+        return "thp";
+    case PageMode::Explicit:
+        return "hugetlb";
+    default:
+        return "default";
+    }
+}
+
+// Random range queries against the same tree backed by base pages, huge pages and interleaved pages
+// The gap grows with the tree, run with --perf and a large --max-size to compare dtlb_load_misses per query.
+void RunMemory(bench::Runner& runner, size_t n, const MemoryOptions& memory)
+{
+    std::vector<int64_t> data(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        data[i] = int64_t(i * 7919 % 1000);
+    }
+
+    std::string name = std::string{ "Memory/query/" } + GetName(memory) + "/" + std::to_string(n);
+    if (!runner.IsEnabled(name))
+    {
+        return;
+    }
+
+    SegmentTree<int64_t> tree{ data, Add, 0, memory };
+
+    bench::Random random{ n };
+
+    std::vector<size_t> lefts(operandCount);
+    std::vector<size_t> rights(operandCount);
+    for (size_t i = 0; i < operandCount; ++i)
+    {
+        size_t a = random.Below(n);
+        size_t b = random.Below(n);
+        lefts[i] = a < b ? a : b;
+        rights[i] = (a < b ? b : a) + 1;
+    }
+
+    runner.Run(name, n, 1, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            bench::DoNotOptimize(tree.Query(lefts[k % operandCount], rights[k % operandCount]));
+        }
+    });
+}
+
+void Run(bench::Runner& runner)
+{
+    const MemoryOptions options[] = {
+        { PageMode::Default, NumaPolicy::Default },
+        { PageMode::Transparent, NumaPolicy::Default },
+        { PageMode::Explicit, NumaPolicy::Default },
+        { PageMode::Default, NumaPolicy::Interleave },
+        { PageMode::Transparent, NumaPolicy::Interleave },
+    };
+
+    for (size_t n : bench::GetSizes(runner.GetOptions()))
+    {
+        for (const MemoryOptions& memory : options)
+        {
+            RunMemory(runner, n, memory);
+        }
+    }
+}
+
+bench::Suite suite{ "Memory", Run };
+
+} // namespace
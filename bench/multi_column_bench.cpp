@@ -0,0 +1,115 @@
+#include "bench.h"
+#include "segment_tree/multi_segment_tree.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+double Add(double a, double b)
+{
+    return a + b;
+}
+
+constexpr size_t operandCount = 4096;
+
+// K independent SegmentTree<double> against one MultiSegmentTree<double, K> over the same indices
+// Every op updates or queries all K columns.
+template <size_t K>
+void RunColumns(bench::Runner& runner, size_t n)
+{
+    using Tree = MultiSegmentTree<double, K, std::plus<>>;
+
+    std::vector<double> data(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        data[i] = double(i * 7919 % 1000);
+    }
+
+    std::vector<SegmentTree<double>> trees;
+    trees.reserve(K);
+    for (size_t k = 0; k < K; ++k)
+    {
+        trees.emplace_back(data, Add, 0.0);
+    }
+
+    std::vector<typename Tree::Row> rows(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        rows[i].fill(data[i]);
+    }
+
+    Tree multi{ rows, typename Tree::Row{} };
+
+    bench::Random random{ n };
+
+    std::vector<size_t> lefts(operandCount);
+    std::vector<size_t> rights(operandCount);
+    for (size_t i = 0; i < operandCount; ++i)
+    {
+        size_t a = random.Below(n);
+        size_t b = random.Below(n);
+        lefts[i] = a < b ? a : b;
+        rights[i] = (a < b ? b : a) + 1;
+    }
+
+    std::string suffix = "/" + std::to_string(K) + "/" + std::to_string(n);
+
+    runner.Run("MultiColumn/update-separate" + suffix, n, 1, [&](size_t iterations) {
+        for (size_t j = 0; j < iterations; ++j)
+        {
+            size_t index = lefts[j % operandCount];
+            for (size_t k = 0; k < K; ++k)
+            {
+                trees[k].Update(index, double(j + k));
+            }
+        }
+    });
+
+    runner.Run("MultiColumn/update-multi" + suffix, n, 1, [&](size_t iterations) {
+        typename Tree::Row row;
+        for (size_t j = 0; j < iterations; ++j)
+        {
+            for (size_t k = 0; k < K; ++k)
+            {
+                row[k] = double(j + k);
+            }
+
+            multi.Update(lefts[j % operandCount], row);
+        }
+    });
+
+    runner.Run("MultiColumn/query-separate" + suffix, n, 1, [&](size_t iterations) {
+        for (size_t j = 0; j < iterations; ++j)
+        {
+            size_t left = lefts[j % operandCount];
+            size_t right = rights[j % operandCount];
+            for (size_t k = 0; k < K; ++k)
+            {
+                bench::DoNotOptimize(trees[k].Query(left, right));
+            }
+        }
+    });
+
+    runner.Run("MultiColumn/query-multi" + suffix, n, 1, [&](size_t iterations) {
+        for (size_t j = 0; j < iterations; ++j)
+        {
+            bench::DoNotOptimize(multi.Query(lefts[j % operandCount], rights[j % operandCount]));
+        }
+    });
+}
+
+void Run(bench::Runner& runner)
+{
+    for (size_t n : bench::GetSizes(runner.GetOptions()))
+    {
+        RunColumns<4>(runner, n);
+        RunColumns<20>(runner, n);
+    }
+}
+
+bench::Suite suite{ "MultiColumn", Run };
+
+} // namespace
@@ -0,0 +1,150 @@
+#include "perf_counters.h"
+
+#if defined(__linux__)
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace bench
+{
+
+#if defined(__linux__)
+
+static int OpenCounter(uint32_t type, uint64_t config)
+{
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+PerfCounters::PerfCounters()
+{
+    struct Event
+    {
+        const char* name;
+        uint32_t type;
+        uint64_t config;
+    };
+
+    const Event events[] = {
+        { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { "cache_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+        { "branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+        { "branches", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS },
+        { "llc_loads", PERF_TYPE_HW_CACHE,
+          PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_ACCESS << 16) },
+        { "dtlb_load_misses", PERF_TYPE_HW_CACHE,
+          PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    };
+
+    for (const Event& event : events)
+    {
+        int fd = OpenCounter(event.type, event.config);
+        if (fd < 0)
+        {
+            if (error.empty())
+            {
+                error = std::string{ event.name } + ": " + std::strerror(errno);
+            }
+            continue;
+        }
+
+        counters.push_back(Counter{ event.name, fd });
+    }
+}
+
+PerfCounters::~PerfCounters() noexcept
+{
+    for (const Counter& counter : counters)
+    {
+        close(counter.fd);
+    }
+}
+
+void PerfCounters::Start()
+{
+    for (const Counter& counter : counters)
+    {
+        ioctl(counter.fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(counter.fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+void PerfCounters::Stop()
+{
+    for (const Counter& counter : counters)
+    {
+        ioctl(counter.fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+}
+
+std::vector<std::pair<std::string, double>> PerfCounters::Read() const
+{
+    std::vector<std::pair<std::string, double>> values;
+
+    for (const Counter& counter : counters)
+    {
+        // value, time enabled, time running
+        uint64_t data[3];
+        if (read(counter.fd, data, sizeof(data)) != ssize_t(sizeof(data)) || data[2] == 0)
+        {
+            continue;
+        }
+
+        double scale = double(data[1]) / double(data[2]);
+        values.emplace_back(counter.name, double(data[0]) * scale);
+    }
+
+    return values;
+}
+
+#else
+
+PerfCounters::PerfCounters()
+    : error{ "perf_event_open is only available on Linux" }
+{
+}
+
+PerfCounters::~PerfCounters() noexcept
+{
+}
+
+void PerfCounters::Start()
+{
+}
+
+void PerfCounters::Stop()
+{
+}
+
+std::vector<std::pair<std::string, double>> PerfCounters::Read() const
+{
+    return {};
+}
+
+#endif
+
+bool PerfCounters::IsAvailable() const
+{
+    return !counters.empty();
+}
+
+const std::string& PerfCounters::GetError() const
+{
+    return error;
+}
+
+} // namespace bench
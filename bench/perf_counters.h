@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+
+// Hardware performance counters read through Linux perf_event_open
+// Counters the kernel refuses to open (containers, perf_event_paranoid, other platforms) are skipped,
+// so the remaining ones keep working and an empty set is reported when none are available.
+class PerfCounters
+{
+public:
+    PerfCounters();
+    ~PerfCounters() noexcept;
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    void Start();
+    void Stop();
+
+    // Names and values of the counters that could be opened, scaled for multiplexing
+    std::vector<std::pair<std::string, double>> Read() const;
+
+    bool IsAvailable() const;
+
+    // Reason the first counter failed to open, empty if all opened
+    const std::string& GetError() const;
+
+private:
+    struct Counter
+    {
+        const char* name;
+        int fd;
+    };
+
+    std::vector<Counter> counters;
+    std::string error;
+};
+
+} // namespace bench
@@ -0,0 +1,73 @@
+#include "bench.h"
+#include "segment_tree/segment_tree.h"
+
+#include <string>
+#include <vector>
+
+namespace
+{
+
+int64_t Add(int64_t a, int64_t b)
+{
+    return a + b;
+}
+
+constexpr size_t operandCount = 4096;
+
+// Random updates and queries with and without prefetching the path below the hot top
+// The difference only shows on trees larger than the last level cache, run with a large --max-size.
+void RunPrefetch(bench::Runner& runner, size_t n, bool prefetch)
+{
+    std::vector<int64_t> data(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        data[i] = int64_t(i * 7919 % 1000);
+    }
+
+    SegmentTree<int64_t> tree{ data, Add, 0 };
+    if (prefetch)
+    {
+        tree.EnablePrefetch();
+    }
+
+    bench::Random random{ n };
+
+    std::vector<size_t> lefts(operandCount);
+    std::vector<size_t> rights(operandCount);
+    for (size_t i = 0; i < operandCount; ++i)
+    {
+        size_t a = random.Below(n);
+        size_t b = random.Below(n);
+        lefts[i] = a < b ? a : b;
+        rights[i] = (a < b ? b : a) + 1;
+    }
+
+    std::string suffix = std::string{ prefetch ? "/prefetch/" : "/default/" } + std::to_string(n);
+
+    runner.Run("HotTop/update" + suffix, n, 1, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            tree.Update(lefts[k % operandCount], int64_t(k));
+        }
+    });
+
+    runner.Run("HotTop/query" + suffix, n, 1, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            bench::DoNotOptimize(tree.Query(lefts[k % operandCount], rights[k % operandCount]));
+        }
+    });
+}
+
+void Run(bench::Runner& runner)
+{
+    for (size_t n : bench::GetSizes(runner.GetOptions()))
+    {
+        RunPrefetch(runner, n, false);
+        RunPrefetch(runner, n, true);
+    }
+}
+
+bench::Suite suite{ "HotTop", Run };
+
+} // namespace
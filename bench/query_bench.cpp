@@ -0,0 +1,148 @@
+#include "bench.h"
+#include "segment_tree/segment_tree.h"
+
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+
+template <typename T>
+T Add(T a, T b)
+{
+    return a + b;
+}
+
+template <typename T>
+T Subtract(T a, T b)
+{
+    return a - b;
+}
+
+template <typename T>
+const char* TypeName()
+{
+    if constexpr (std::is_same_v<T, int32_t>) return "int32";
+    if constexpr (std::is_same_v<T, int64_t>) return "int64";
+    if constexpr (std::is_same_v<T, double>) return "double";
+}
+
+constexpr size_t operandCount = 4096;
+constexpr size_t latencySamples = 200000;
+
+// Per-call latency distribution, each sample includes the cost of reading the clock
+template <typename F>
+void RecordLatency(bench::Runner& runner, F&& query)
+{
+    using Clock = std::chrono::steady_clock;
+
+    LatencyHistogram histogram;
+    for (size_t k = 0; k < latencySamples; ++k)
+    {
+        Clock::time_point begin = Clock::now();
+        bench::DoNotOptimize(query(k % operandCount));
+        Clock::time_point end = Clock::now();
+
+        histogram.Record(uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count()));
+    }
+
+    runner.AddMetric("latency_p50_ns", double(histogram.GetPercentile(50)));
+    runner.AddMetric("latency_p99_ns", double(histogram.GetPercentile(99)));
+    runner.AddMetric("latency_p999_ns", double(histogram.GetPercentile(99.9)));
+}
+
+// Branching versus branchless Query on random ranges
+// Run with --perf to compare branch misses per query.
+template <typename T>
+void RunType(bench::Runner& runner, size_t n)
+{
+    std::vector<T> data(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        data[i] = T(i * 7919 % 1000);
+    }
+
+    SegmentTree<T> tree{ data, Add<T>, T{} };
+
+    bench::Random random{ n };
+
+    std::vector<size_t> lefts(operandCount);
+    std::vector<size_t> rights(operandCount);
+    for (size_t i = 0; i < operandCount; ++i)
+    {
+        size_t a = random.Below(n);
+        size_t b = random.Below(n);
+        lefts[i] = a < b ? a : b;
+        rights[i] = (a < b ? b : a) + 1;
+    }
+
+    auto query = [&](size_t j) { return tree.Query(lefts[j], rights[j]); };
+    auto queryBranchless = [&](size_t j) { return tree.QueryBranchless(lefts[j], rights[j]); };
+
+    std::string suffix = std::string{ "/" } + TypeName<T>() + "/" + std::to_string(n);
+
+    std::string name = "Query/branching" + suffix;
+    runner.Run(name, n, 1, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            bench::DoNotOptimize(query(k % operandCount));
+        }
+    });
+
+    if (runner.IsEnabled(name))
+    {
+        RecordLatency(runner, query);
+    }
+
+    name = "Query/branchless" + suffix;
+    runner.Run(name, n, 1, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            bench::DoNotOptimize(queryBranchless(k % operandCount));
+        }
+    });
+
+    if (runner.IsEnabled(name))
+    {
+        RecordLatency(runner, queryBranchless);
+    }
+
+    // Prefixes through the general loop, the single-boundary walk and the cache
+    runner.Run("Query/prefix-general" + suffix, n, 1, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            bench::DoNotOptimize(tree.Query(0, rights[k % operandCount]));
+        }
+    });
+
+    runner.Run("Query/prefix" + suffix, n, 1, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            bench::DoNotOptimize(tree.PrefixQuery(rights[k % operandCount]));
+        }
+    });
+
+    tree.EnablePrefixCache(Subtract<T>);
+
+    runner.Run("Query/prefix-cached" + suffix, n, 1, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            bench::DoNotOptimize(tree.PrefixQuery(rights[k % operandCount]));
+        }
+    });
+}
+
+void Run(bench::Runner& runner)
+{
+    for (size_t n : bench::GetSizes(runner.GetOptions()))
+    {
+        RunType<int32_t>(runner, n);
+        RunType<int64_t>(runner, n);
+        RunType<double>(runner, n);
+    }
+}
+
+bench::Suite suite{ "Query", Run };
+
+} // namespace
@@ -0,0 +1,227 @@
+#include "bench.h"
+#include "segment_tree/segment_tree.h"
+
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+
+// 64-byte aggregate, representative of multi-field node payloads
+struct Big64
+{
+    int64_t v[8];
+
+    Big64 operator+(const Big64& other) const
+    {
+        Big64 result;
+        for (int i = 0; i < 8; ++i)
+        {
+            result.v[i] = v[i] + other.v[i];
+        }
+
+        return result;
+    }
+};
+
+// Value-initialized T is the identity for every benchmarked type
+template <typename T>
+T Add(T a, T b)
+{
+    return a + b;
+}
+
+template <typename T>
+T Subtract(T a, T b)
+{
+    return a - b;
+}
+
+template <typename T>
+T MakeValue(uint64_t x)
+{
+    if constexpr (std::is_same_v<T, Big64>)
+    {
+        Big64 value;
+        for (int i = 0; i < 8; ++i)
+        {
+            value.v[i] = int64_t(x + i);
+        }
+
+        return value;
+    }
+    else
+    {
+        return T(x % 1000);
+    }
+}
+
+template <typename T>
+const char* TypeName()
+{
+    if constexpr (std::is_same_v<T, int32_t>) return "int32";
+    if constexpr (std::is_same_v<T, int64_t>) return "int64";
+    if constexpr (std::is_same_v<T, double>) return "double";
+    if constexpr (std::is_same_v<T, Big64>) return "big64";
+}
+
+std::string Name(const char* op, const char* pattern, const char* type, size_t n)
+{
+    std::string name = "SegmentTree/";
+    name += op;
+    if (pattern != nullptr)
+    {
+        name += '/';
+        name += pattern;
+    }
+    name += '/';
+    name += type;
+    name += '/';
+    name += std::to_string(n);
+    return name;
+}
+
+// Precomputed operands so the generator stays out of the measured loop
+constexpr size_t operandCount = 4096;
+
+template <typename T>
+void RunType(bench::Runner& runner, size_t n)
+{
+    const char* type = TypeName<T>();
+
+    std::vector<T> data(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        data[i] = MakeValue<T>(i * 7919);
+    }
+
+    bench::Random random{ n };
+
+    std::vector<size_t> lefts(operandCount);
+    std::vector<size_t> rights(operandCount);
+    std::vector<size_t> indices(operandCount);
+    for (size_t i = 0; i < operandCount; ++i)
+    {
+        size_t a = random.Below(n);
+        size_t b = random.Below(n);
+        lefts[i] = a < b ? a : b;
+        rights[i] = (a < b ? b : a) + 1;
+        indices[i] = random.Below(n);
+    }
+
+    // Construction, reported per element
+    runner.Run(Name("Construct", nullptr, type, n), n, n, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            SegmentTree<T> tree{ data, Add<T>, T{} };
+            bench::DoNotOptimize(tree.GetTree()[1]);
+        }
+    });
+
+    // Growing from a single element, reported per element
+    runner.Run(Name("PushBack", nullptr, type, n), n, n, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            SegmentTree<T> tree{ std::span<T>{ data.data(), 1 }, Add<T>, T{} };
+            for (size_t i = 1; i < n; ++i)
+            {
+                tree.PushBack(data[i]);
+            }
+            bench::DoNotOptimize(tree.GetTree()[1]);
+        }
+    });
+
+    SegmentTree<T> tree{ data, Add<T>, T{} };
+
+    runner.Run(Name("Query", "random", type, n), n, 1, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            size_t j = k % operandCount;
+            bench::DoNotOptimize(tree.Query(lefts[j], rights[j]));
+        }
+    });
+
+    // Equal-width windows sliding forward by one element
+    size_t width = n / 4;
+    runner.Run(Name("Query", "sequential", type, n), n, 1, [&](size_t iterations) {
+        size_t left = 0;
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            bench::DoNotOptimize(tree.Query(left, left + width));
+            left = left + 1 < n - width ? left + 1 : 0;
+        }
+    });
+
+    // The written values shift on every pass over the operands, so the walks cannot stop early on unchanged nodes
+    runner.Run(Name("Update", "random", type, n), n, 1, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            size_t j = k % operandCount;
+            tree.Update(indices[j], data[(j + k / operandCount) % n]);
+        }
+        bench::DoNotOptimize(tree.GetTree()[1]);
+    });
+
+    runner.Run(Name("Update", "sequential", type, n), n, 1, [&](size_t iterations) {
+        size_t index = 0;
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            tree.Update(index, data[(k + k / n) % n]);
+            index = index + 1 < n ? index + 1 : 0;
+        }
+        bench::DoNotOptimize(tree.GetTree()[1]);
+    });
+
+    if constexpr (std::is_arithmetic_v<T>)
+    {
+        // Deltas alternate in sign so the sums stay bounded
+        runner.Run(Name("Add", "random", type, n), n, 1, [&](size_t iterations) {
+            for (size_t k = 0; k < iterations; ++k)
+            {
+                size_t j = k % operandCount;
+                tree.Add(indices[j], (k & 1) ? data[j] : T(-data[j]));
+            }
+            bench::DoNotOptimize(tree.GetTree()[1]);
+        });
+
+        // Update through the declared inverse, touching one node per level
+        SegmentTree<T> deltaTree{ data, Add<T>, T{} };
+        deltaTree.SetInverse(Subtract<T>);
+
+        runner.Run(Name("Update", "random-delta", type, n), n, 1, [&](size_t iterations) {
+            for (size_t k = 0; k < iterations; ++k)
+            {
+                size_t j = k % operandCount;
+                deltaTree.Update(indices[j], data[(j + k / operandCount) % n]);
+            }
+            bench::DoNotOptimize(deltaTree.GetTree()[1]);
+        });
+    }
+
+    // Each insertion is paired with a PopBack to keep the element count stable
+    runner.Run(Name("Insert", "random", type, n), n, 1, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            size_t j = k % operandCount;
+            tree.Insert(indices[j], data[j]);
+            tree.PopBack();
+        }
+        bench::DoNotOptimize(tree.GetTree()[1]);
+    });
+}
+
+void Run(bench::Runner& runner)
+{
+    for (size_t n : bench::GetSizes(runner.GetOptions()))
+    {
+        RunType<int32_t>(runner, n);
+        RunType<int64_t>(runner, n);
+        RunType<double>(runner, n);
+        RunType<Big64>(runner, n);
+    }
+}
+
+bench::Suite suite{ "SegmentTree", Run };
+
+} // namespace
@@ -0,0 +1,220 @@
+#include "bench.h"
+#include "segment_tree/segment_tree.h"
+#include "segment_tree/seqlock_segment_tree.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+int64_t Add(int64_t a, int64_t b)
+{
+    return a + b;
+}
+
+constexpr size_t operandCount = 4096;
+
+// Gap between two updates of the background writer
+constexpr std::chrono::microseconds writerPeriod{ 1 };
+
+// Runs read(k) for k in [0, iterations) on each of readerCount threads,
+// while a writer thread applies write(k) once per writerPeriod until every reader is done
+template <typename Read, typename Write>
+void RunReaders(size_t readerCount, size_t iterations, Read read, Write write)
+{
+    std::atomic<bool> done{ false };
+
+    std::thread writer{ [&]() {
+        using Clock = std::chrono::steady_clock;
+
+        Clock::time_point next = Clock::now();
+        for (size_t k = 0; !done.load(std::memory_order_relaxed); ++k)
+        {
+            write(k);
+
+            next += writerPeriod;
+            while (Clock::now() < next && !done.load(std::memory_order_relaxed))
+            {
+                std::this_thread::yield();
+            }
+        }
+    } };
+
+    std::vector<std::thread> readers;
+    for (size_t t = 0; t < readerCount; ++t)
+    {
+        readers.emplace_back([&, t]() {
+            for (size_t k = 0; k < iterations; ++k)
+            {
+                read(k + t * 997);
+            }
+        });
+    }
+
+    for (std::thread& reader : readers)
+    {
+        reader.join();
+    }
+
+    done.store(true, std::memory_order_relaxed);
+    writer.join();
+}
+
+// Number of individually timed writes when measuring the slowest one
+constexpr size_t latencySamples = 100000;
+
+// Runs write(k) for k in [0, iterations) on the calling thread while readerCount threads query continuously,
+// when maxLatency is given every write is timed and the slowest one is stored into it
+template <typename Read, typename Write>
+void RunWriter(size_t readerCount, size_t iterations, Read read, Write write, std::chrono::nanoseconds* maxLatency = nullptr)
+{
+    using Clock = std::chrono::steady_clock;
+
+    std::atomic<bool> done{ false };
+
+    std::vector<std::thread> readers;
+    for (size_t t = 0; t < readerCount; ++t)
+    {
+        readers.emplace_back([&, t]() {
+            for (size_t k = t * 997; !done.load(std::memory_order_relaxed); ++k)
+            {
+                read(k);
+            }
+        });
+    }
+
+    if (maxLatency)
+    {
+        *maxLatency = std::chrono::nanoseconds::zero();
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            Clock::time_point begin = Clock::now();
+            write(k);
+            *maxLatency = std::max(*maxLatency, std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin));
+        }
+    }
+    else
+    {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            write(k);
+        }
+    }
+
+    done.store(true, std::memory_order_relaxed);
+    for (std::thread& reader : readers)
+    {
+        reader.join();
+    }
+}
+
+// Seqlock readers against readers sharing a mutex with the writer.
+// Query ns/op is the aggregate over every reader, near-linear scaling shows as ns/op dropping with the reader count.
+// Update ns/op is the writer latency while the readers query continuously,
+// the slowest of a separate pass of individually timed updates is attached as a metric.
+// Reader counts go up to the hardware thread count.
+void RunSeqlock(bench::Runner& runner, size_t n)
+{
+    std::vector<int64_t> data(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        data[i] = int64_t(i * 7919 % 1000);
+    }
+
+    bench::Random random{ n };
+
+    std::vector<size_t> lefts(operandCount);
+    std::vector<size_t> rights(operandCount);
+    for (size_t i = 0; i < operandCount; ++i)
+    {
+        size_t a = random.Below(n);
+        size_t b = random.Below(n);
+        lefts[i] = a < b ? a : b;
+        rights[i] = (a < b ? b : a) + 1;
+    }
+
+    std::string suffix = "/" + std::to_string(n);
+
+    SeqlockSegmentTree<int64_t, std::plus<>> seqlock{ data, 0 };
+
+    SegmentTree<int64_t> locked{ data, Add, 0 };
+    std::mutex mutex;
+
+    auto readSeqlock = [&](size_t k) {
+        bench::DoNotOptimize(seqlock.Query(lefts[k % operandCount], rights[k % operandCount]));
+    };
+
+    auto writeSeqlock = [&](size_t k) {
+        seqlock.Update(lefts[k % operandCount], int64_t(k % 1000));
+    };
+
+    auto readLocked = [&](size_t k) {
+        std::lock_guard<std::mutex> lock{ mutex };
+        bench::DoNotOptimize(locked.Query(lefts[k % operandCount], rights[k % operandCount]));
+    };
+
+    auto writeLocked = [&](size_t k) {
+        std::lock_guard<std::mutex> lock{ mutex };
+        locked.Update(lefts[k % operandCount], int64_t(k % 1000));
+    };
+
+    size_t maxReaders = std::max<size_t>(1, std::thread::hardware_concurrency());
+
+    for (size_t readers = 1; readers <= maxReaders; readers *= 2)
+    {
+        std::string name = "/" + std::to_string(readers) + "-readers" + suffix;
+
+        runner.Run("Seqlock/query/seqlock" + name, n, readers, [&](size_t iterations) {
+            RunReaders(readers, iterations, readSeqlock, writeSeqlock);
+        });
+
+        runner.Run("Seqlock/query/mutex" + name, n, readers, [&](size_t iterations) {
+            RunReaders(readers, iterations, readLocked, writeLocked);
+        });
+
+        std::chrono::nanoseconds maxLatency{};
+
+        std::string seqlockName = "Seqlock/update/seqlock" + name;
+
+        runner.Run(seqlockName, n, 1, [&](size_t iterations) {
+            RunWriter(readers, iterations, readSeqlock, writeSeqlock);
+        });
+
+        if (runner.IsEnabled(seqlockName))
+        {
+            RunWriter(readers, latencySamples, readSeqlock, writeSeqlock, &maxLatency);
+            runner.AddMetric("max-update-ns", double(maxLatency.count()));
+        }
+
+        std::string mutexName = "Seqlock/update/mutex" + name;
+
+        runner.Run(mutexName, n, 1, [&](size_t iterations) {
+            RunWriter(readers, iterations, readLocked, writeLocked);
+        });
+
+        if (runner.IsEnabled(mutexName))
+        {
+            RunWriter(readers, latencySamples, readLocked, writeLocked, &maxLatency);
+            runner.AddMetric("max-update-ns", double(maxLatency.count()));
+        }
+    }
+}
+
+void Run(bench::Runner& runner)
+{
+    for (size_t n : bench::GetSizes(runner.GetOptions()))
+    {
+        RunSeqlock(runner, n);
+    }
+}
+
+bench::Suite suite{ "Seqlock", Run };
+
+} // namespace
@@ -0,0 +1,116 @@
+#include "bench.h"
+#include "segment_tree/multi_segment_tree.h"
+#include "segment_tree/segment_tree.h"
+#include "segment_tree/veb_segment_tree.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+int64_t Add(int64_t a, int64_t b)
+{
+    return a + b;
+}
+
+constexpr size_t operandCount = 4096;
+
+// Level-order layouts against the van Emde Boas layout on random walks over the whole tree.
+// The single-column MultiSegmentTree uses the same stateless combine as the van Emde Boas tree,
+// so the two differ only in layout, while SegmentTree is the default tree as users build it.
+// Sizes past the last level cache need --max-size, up to 1073741824.
+void RunVeb(bench::Runner& runner, size_t n)
+{
+    std::vector<int64_t> data(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        data[i] = int64_t(i * 7919 % 1000);
+    }
+
+    bench::Random random{ n };
+
+    std::vector<size_t> lefts(operandCount);
+    std::vector<size_t> rights(operandCount);
+    for (size_t i = 0; i < operandCount; ++i)
+    {
+        size_t a = random.Below(n);
+        size_t b = random.Below(n);
+        lefts[i] = a < b ? a : b;
+        rights[i] = (a < b ? b : a) + 1;
+    }
+
+    std::vector<std::array<int64_t, 1>> rows(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        rows[i] = { data[i] };
+    }
+
+    std::string suffix = "/" + std::to_string(n);
+
+    SegmentTree<int64_t> full{ data, Add, 0 };
+    MultiSegmentTree<int64_t, 1, std::plus<>> level{ rows, { 0 } };
+    VebSegmentTree<int64_t, std::plus<>> veb{ data, 0 };
+
+    runner.Run("Veb/query/segment-tree" + suffix, n, 1, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            bench::DoNotOptimize(full.Query(lefts[k % operandCount], rights[k % operandCount]));
+        }
+    });
+
+    runner.AddMetric("tree-bytes", double(full.GetAllocatedBytes()));
+
+    runner.Run("Veb/query/level-order" + suffix, n, 1, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            bench::DoNotOptimize(level.Query(lefts[k % operandCount], rights[k % operandCount], 0));
+        }
+    });
+
+    runner.Run("Veb/query/veb" + suffix, n, 1, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            bench::DoNotOptimize(veb.Query(lefts[k % operandCount], rights[k % operandCount]));
+        }
+    });
+
+    runner.AddMetric("tree-bytes", double(veb.GetTreeSize() * sizeof(int64_t)));
+
+    runner.Run("Veb/update/segment-tree" + suffix, n, 1, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            full.Update(lefts[k % operandCount], int64_t(k % 1000));
+        }
+        bench::DoNotOptimize(full.GetTree()[1]);
+    });
+
+    runner.Run("Veb/update/level-order" + suffix, n, 1, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            level.Update(lefts[k % operandCount], 0, int64_t(k % 1000));
+        }
+        bench::DoNotOptimize(level.GetNode(1)[0]);
+    });
+
+    runner.Run("Veb/update/veb" + suffix, n, 1, [&](size_t iterations) {
+        for (size_t k = 0; k < iterations; ++k)
+        {
+            veb.Update(lefts[k % operandCount], int64_t(k % 1000));
+        }
+        bench::DoNotOptimize(veb.GetTree()[1]);
+    });
+}
+
+void Run(bench::Runner& runner)
+{
+    for (size_t n : bench::GetSizes(runner.GetOptions()))
+    {
+        RunVeb(runner, n);
+    }
+}
+
+bench::Suite suite{ "Veb", Run };
+
+} // namespace
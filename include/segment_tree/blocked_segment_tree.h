@@ -0,0 +1,301 @@
+#pragma once
+
+#include "segment_tree.h"
+
+#include <algorithm>
+
+// Segment tree over buckets of B consecutive elements.
+// The raw values are stored in one flat array and only the bucket aggregates are kept in the tree,
+// so the internal nodes take B times less memory and every walk is log2(B) levels shorter.
+// The partial buckets at the edges of a query are scanned linearly, a fixed-length loop the compiler can vectorize.
+// Op is a stateless function object such as std::plus<>.
+template <typename T, size_t B, typename Op>
+class BlockedSegmentTree
+{
+    static_assert(B > 0, "BlockedSegmentTree requires a non-empty bucket");
+
+public:
+    BlockedSegmentTree(std::span<const T> data, T noneValue);
+    ~BlockedSegmentTree() noexcept;
+
+    BlockedSegmentTree(const BlockedSegmentTree& other);
+    BlockedSegmentTree& operator=(const BlockedSegmentTree& other);
+    BlockedSegmentTree(BlockedSegmentTree&& other) noexcept;
+    BlockedSegmentTree& operator=(BlockedSegmentTree&& other) noexcept;
+
+    // Combination over [left, right)
+    T Query(size_t left, size_t right) const;
+
+    // Rescans the bucket of index, then walks the bucket tree
+    void Update(size_t index, T newValue);
+
+    T operator[](size_t index) const;
+
+    size_t GetCount() const;
+    size_t GetBucketCount() const;
+    const T* GetTree() const;
+    size_t GetTreeSize() const;
+
+    // Bytes of the bucket tree and the raw values
+    size_t GetAllocatedBytes() const;
+
+    T GetNoneValue() const;
+
+private:
+    // Bucket tree, indexed the same way as in SegmentTree with one leaf per bucket
+    // Root starts from index 1
+    // noneValue is stored in the first element
+    T* tree;
+
+    // Raw values, bucketCount * B of them, the tail of the last bucket is padded with noneValue
+    T* values;
+
+    [[no_unique_address]] Op combineFcn;
+
+    // Count of original elements
+    size_t count;
+
+    size_t bucketCount;
+
+    // Size of the bucket tree array
+    size_t size;
+
+    // Left fold of [first, last) onto value
+    T Scan(T value, const T* first, const T* last) const;
+
+    void Build();
+};
+
+template <typename T, size_t B, typename Op>
+inline BlockedSegmentTree<T, B, Op>::BlockedSegmentTree(std::span<const T> data, T noneValue)
+    : combineFcn{}
+    , count{ data.size() }
+    , bucketCount{ (data.size() + B - 1) / B }
+    , size{ compute_size(bucketCount) }
+{
+    values = new T[bucketCount * B];
+    std::copy(data.begin(), data.end(), values);
+    std::fill(values + count, values + bucketCount * B, noneValue);
+
+    tree = new T[size];
+    tree[0] = noneValue;
+
+    Build();
+}
+
+template <typename T, size_t B, typename Op>
+inline BlockedSegmentTree<T, B, Op>::~BlockedSegmentTree() noexcept
+{
+    delete[] tree;
+    delete[] values;
+}
+
+template <typename T, size_t B, typename Op>
+inline BlockedSegmentTree<T, B, Op>::BlockedSegmentTree(const BlockedSegmentTree& other)
+{
+    count = other.count;
+    bucketCount = other.bucketCount;
+    size = other.size;
+
+    tree = new T[size];
+    std::copy(other.tree, other.tree + size, tree);
+
+    values = new T[bucketCount * B];
+    std::copy(other.values, other.values + bucketCount * B, values);
+}
+
+template <typename T, size_t B, typename Op>
+inline BlockedSegmentTree<T, B, Op>& BlockedSegmentTree<T, B, Op>::operator=(const BlockedSegmentTree& other)
+{
+    if (this != &other)
+    {
+        delete[] tree;
+        delete[] values;
+
+        count = other.count;
+        bucketCount = other.bucketCount;
+        size = other.size;
+
+        tree = new T[size];
+        std::copy(other.tree, other.tree + size, tree);
+
+        values = new T[bucketCount * B];
+        std::copy(other.values, other.values + bucketCount * B, values);
+    }
+
+    return *this;
+}
+
+template <typename T, size_t B, typename Op>
+inline BlockedSegmentTree<T, B, Op>::BlockedSegmentTree(BlockedSegmentTree&& other) noexcept
+{
+    tree = other.tree;
+    values = other.values;
+    count = other.count;
+    bucketCount = other.bucketCount;
+    size = other.size;
+
+    other.tree = nullptr;
+    other.values = nullptr;
+    other.count = 0;
+    other.bucketCount = 0;
+    other.size = 0;
+}
+
+template <typename T, size_t B, typename Op>
+inline BlockedSegmentTree<T, B, Op>& BlockedSegmentTree<T, B, Op>::operator=(BlockedSegmentTree&& other) noexcept
+{
+    if (this != &other)
+    {
+        delete[] tree;
+        delete[] values;
+
+        tree = other.tree;
+        values = other.values;
+        count = other.count;
+        bucketCount = other.bucketCount;
+        size = other.size;
+
+        other.tree = nullptr;
+        other.values = nullptr;
+        other.count = 0;
+        other.bucketCount = 0;
+        other.size = 0;
+    }
+
+    return *this;
+}
+
+template <typename T, size_t B, typename Op>
+inline T BlockedSegmentTree<T, B, Op>::Query(size_t left, size_t right) const
+{
+    assert(left < right && right <= count);
+
+    size_t first = left / B;
+    size_t last = (right - 1) / B;
+
+    if (first == last)
+    {
+        return Scan(tree[0], values + left, values + right);
+    }
+
+    T leftValue = Scan(tree[0], values + left, values + (first + 1) * B);
+
+    // Whole buckets strictly between the two edge buckets
+    size_t l = size / 2 + first + 1;
+    size_t r = size / 2 + last;
+
+    T rightValue = tree[0];
+
+    while (l < r)
+    {
+        if (l & 1)
+        {
+            leftValue = combineFcn(leftValue, tree[l++]);
+        }
+
+        if (r & 1)
+        {
+            rightValue = combineFcn(tree[--r], rightValue);
+        }
+
+        l /= 2;
+        r /= 2;
+    }
+
+    leftValue = combineFcn(leftValue, rightValue);
+
+    return Scan(leftValue, values + last * B, values + right);
+}
+
+template <typename T, size_t B, typename Op>
+inline void BlockedSegmentTree<T, B, Op>::Update(size_t index, T newValue)
+{
+    assert(index < count);
+
+    values[index] = newValue;
+
+    size_t bucket = index / B;
+    size_t i = size / 2 + bucket;
+
+    tree[i] = Scan(tree[0], values + bucket * B, values + bucket * B + B);
+
+    while (i > 1)
+    {
+        i /= 2;
+        tree[i] = combineFcn(tree[2 * i], tree[2 * i + 1]);
+    }
+}
+
+template <typename T, size_t B, typename Op>
+inline T BlockedSegmentTree<T, B, Op>::operator[](size_t index) const
+{
+    assert(index < count);
+
+    return values[index];
+}
+
+template <typename T, size_t B, typename Op>
+inline size_t BlockedSegmentTree<T, B, Op>::GetCount() const
+{
+    return count;
+}
+
+template <typename T, size_t B, typename Op>
+inline size_t BlockedSegmentTree<T, B, Op>::GetBucketCount() const
+{
+    return bucketCount;
+}
+
+template <typename T, size_t B, typename Op>
+inline const T* BlockedSegmentTree<T, B, Op>::GetTree() const
+{
+    return tree;
+}
+
+template <typename T, size_t B, typename Op>
+inline size_t BlockedSegmentTree<T, B, Op>::GetTreeSize() const
+{
+    return size;
+}
+
+template <typename T, size_t B, typename Op>
+inline size_t BlockedSegmentTree<T, B, Op>::GetAllocatedBytes() const
+{
+    return (size + bucketCount * B) * sizeof(T);
+}
+
+template <typename T, size_t B, typename Op>
+inline T BlockedSegmentTree<T, B, Op>::GetNoneValue() const
+{
+    return tree[0];
+}
+
+template <typename T, size_t B, typename Op>
+inline T BlockedSegmentTree<T, B, Op>::Scan(T value, const T* first, const T* last) const
+{
+    for (; first != last; ++first)
+    {
+        value = combineFcn(value, *first);
+    }
+
+    return value;
+}
+
+template <typename T, size_t B, typename Op>
+inline void BlockedSegmentTree<T, B, Op>::Build()
+{
+    size_t mid = size / 2;
+
+    for (size_t b = 0; b < bucketCount; ++b)
+    {
+        tree[mid + b] = Scan(tree[0], values + b * B, values + b * B + B);
+    }
+
+    std::fill(tree + mid + bucketCount, tree + size, tree[0]);
+
+    for (size_t i = mid - 1; i > 0; --i)
+    {
+        tree[i] = combineFcn(tree[2 * i], tree[2 * i + 1]);
+    }
+}
@@ -0,0 +1,263 @@
+#pragma once
+
+#include "segment_tree.h"
+
+#include <algorithm>
+
+// Segment tree with separate leaf and internal node types, e.g. uint8_t counts summed into uint64_t nodes.
+// Leaves are stored unpadded in a compact array of Leaf, the internal nodes in an array of Node,
+// so leaf storage costs sizeof(Leaf) per element instead of sizeof(Node).
+// Lift converts a leaf into a node, Op combines two nodes, both are stateless function objects.
+template <typename Leaf, typename Node, typename Lift, typename Op>
+class CompactLeafSegmentTree
+{
+public:
+    CompactLeafSegmentTree(std::span<const Leaf> data, Node noneValue);
+    ~CompactLeafSegmentTree() noexcept;
+
+    CompactLeafSegmentTree(const CompactLeafSegmentTree& other);
+    CompactLeafSegmentTree& operator=(const CompactLeafSegmentTree& other);
+    CompactLeafSegmentTree(CompactLeafSegmentTree&& other) noexcept;
+    CompactLeafSegmentTree& operator=(CompactLeafSegmentTree&& other) noexcept;
+
+    Node Query(size_t left, size_t right) const;
+    void Update(size_t index, Leaf newValue);
+
+    Leaf operator[](size_t index) const;
+
+    size_t GetCount() const;
+    const Node* GetTree() const;
+    const Leaf* GetLeaves() const;
+    size_t GetTreeSize() const;
+    Node GetNoneValue() const;
+
+private:
+    // Internal nodes of the tree, indexed the same way as in SegmentTree
+    // Root starts from index 1
+    // noneValue is stored in the first element
+    Node* tree;
+
+    // Leaves, logically located at [size / 2, size / 2 + count), the padding is not stored
+    Leaf* leaves;
+
+    [[no_unique_address]] Lift liftFcn;
+    [[no_unique_address]] Op combineFcn;
+
+    // Count of leaves
+    size_t count;
+
+    // Size of the equivalent SegmentTree array, only the first half is allocated as nodes
+    size_t size;
+
+    Node GetNode(size_t i) const;
+    void Build();
+};
+
+template <typename Leaf, typename Node, typename Lift, typename Op>
+inline CompactLeafSegmentTree<Leaf, Node, Lift, Op>::CompactLeafSegmentTree(std::span<const Leaf> data, Node noneValue)
+    : liftFcn{}
+    , combineFcn{}
+    , count{ data.size() }
+    , size{ compute_size(data.size()) }
+{
+    tree = new Node[size / 2];
+    tree[0] = noneValue;
+
+    leaves = new Leaf[count];
+    std::copy(data.begin(), data.end(), leaves);
+
+    Build();
+}
+
+template <typename Leaf, typename Node, typename Lift, typename Op>
+inline CompactLeafSegmentTree<Leaf, Node, Lift, Op>::~CompactLeafSegmentTree() noexcept
+{
+    delete[] tree;
+    delete[] leaves;
+}
+
+template <typename Leaf, typename Node, typename Lift, typename Op>
+inline CompactLeafSegmentTree<Leaf, Node, Lift, Op>::CompactLeafSegmentTree(const CompactLeafSegmentTree& other)
+{
+    count = other.count;
+    size = other.size;
+
+    tree = new Node[size / 2];
+    std::copy(other.tree, other.tree + size / 2, tree);
+
+    leaves = new Leaf[count];
+    std::copy(other.leaves, other.leaves + count, leaves);
+}
+
+template <typename Leaf, typename Node, typename Lift, typename Op>
+inline CompactLeafSegmentTree<Leaf, Node, Lift, Op>& CompactLeafSegmentTree<Leaf, Node, Lift, Op>::operator=(
+    const CompactLeafSegmentTree& other)
+{
+    if (this != &other)
+    {
+        delete[] tree;
+        delete[] leaves;
+
+        count = other.count;
+        size = other.size;
+
+        tree = new Node[size / 2];
+        std::copy(other.tree, other.tree + size / 2, tree);
+
+        leaves = new Leaf[count];
+        std::copy(other.leaves, other.leaves + count, leaves);
+    }
+
+    return *this;
+}
+
+template <typename Leaf, typename Node, typename Lift, typename Op>
+inline CompactLeafSegmentTree<Leaf, Node, Lift, Op>::CompactLeafSegmentTree(CompactLeafSegmentTree&& other) noexcept
+{
+    tree = other.tree;
+    leaves = other.leaves;
+    count = other.count;
+    size = other.size;
+
+    other.tree = nullptr;
+    other.leaves = nullptr;
+    other.count = 0;
+    other.size = 0;
+}
+
+template <typename Leaf, typename Node, typename Lift, typename Op>
+inline CompactLeafSegmentTree<Leaf, Node, Lift, Op>& CompactLeafSegmentTree<Leaf, Node, Lift, Op>::operator=(
+    CompactLeafSegmentTree&& other) noexcept
+{
+    if (this != &other)
+    {
+        delete[] tree;
+        delete[] leaves;
+
+        tree = other.tree;
+        leaves = other.leaves;
+        count = other.count;
+        size = other.size;
+
+        other.tree = nullptr;
+        other.leaves = nullptr;
+        other.count = 0;
+        other.size = 0;
+    }
+
+    return *this;
+}
+
+template <typename Leaf, typename Node, typename Lift, typename Op>
+inline Node CompactLeafSegmentTree<Leaf, Node, Lift, Op>::Query(size_t left, size_t right) const
+{
+    assert(left < right && right <= count);
+
+    left += size / 2;
+    right += size / 2 - 1;
+
+    Node leftValue = GetNoneValue();
+    Node rightValue = GetNoneValue();
+
+    while (left <= right)
+    {
+        if (left & 1)
+        {
+            leftValue = combineFcn(leftValue, GetNode(left));
+        }
+
+        if (~right & 1)
+        {
+            rightValue = combineFcn(GetNode(right), rightValue);
+        }
+
+        left = (left + 1) / 2;
+        right = (right - 1) / 2;
+    }
+
+    return combineFcn(leftValue, rightValue);
+}
+
+template <typename Leaf, typename Node, typename Lift, typename Op>
+inline void CompactLeafSegmentTree<Leaf, Node, Lift, Op>::Update(size_t index, Leaf newValue)
+{
+    assert(index < count);
+
+    leaves[index] = newValue;
+
+    size_t i = (size / 2 + index) / 2;
+
+    while (i > 0)
+    {
+        tree[i] = combineFcn(GetNode(2 * i), GetNode(2 * i + 1));
+        i /= 2;
+    }
+}
+
+template <typename Leaf, typename Node, typename Lift, typename Op>
+inline Leaf CompactLeafSegmentTree<Leaf, Node, Lift, Op>::operator[](size_t index) const
+{
+    return leaves[index];
+}
+
+template <typename Leaf, typename Node, typename Lift, typename Op>
+inline size_t CompactLeafSegmentTree<Leaf, Node, Lift, Op>::GetCount() const
+{
+    return count;
+}
+
+template <typename Leaf, typename Node, typename Lift, typename Op>
+inline const Node* CompactLeafSegmentTree<Leaf, Node, Lift, Op>::GetTree() const
+{
+    return tree;
+}
+
+template <typename Leaf, typename Node, typename Lift, typename Op>
+inline const Leaf* CompactLeafSegmentTree<Leaf, Node, Lift, Op>::GetLeaves() const
+{
+    return leaves;
+}
+
+template <typename Leaf, typename Node, typename Lift, typename Op>
+inline size_t CompactLeafSegmentTree<Leaf, Node, Lift, Op>::GetTreeSize() const
+{
+    return size;
+}
+
+template <typename Leaf, typename Node, typename Lift, typename Op>
+inline Node CompactLeafSegmentTree<Leaf, Node, Lift, Op>::GetNoneValue() const
+{
+    return tree[0];
+}
+
+template <typename Leaf, typename Node, typename Lift, typename Op>
+inline Node CompactLeafSegmentTree<Leaf, Node, Lift, Op>::GetNode(size_t i) const
+{
+    size_t mid = size / 2;
+    if (i < mid)
+    {
+        return tree[i];
+    }
+
+    // Leaves past the end of the array are padding
+    i -= mid;
+    return i < count ? liftFcn(leaves[i]) : tree[0];
+}
+
+template <typename Leaf, typename Node, typename Lift, typename Op>
+inline void CompactLeafSegmentTree<Leaf, Node, Lift, Op>::Build()
+{
+    size_t mid = size / 2;
+
+    // The lowest internal level lifts the leaves
+    size_t i = mid - 1;
+    for (; i >= mid / 2 && i > 0; --i)
+    {
+        tree[i] = combineFcn(GetNode(2 * i), GetNode(2 * i + 1));
+    }
+
+    for (; i > 0; --i)
+    {
+        tree[i] = combineFcn(tree[2 * i], tree[2 * i + 1]);
+    }
+}
@@ -0,0 +1,249 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+// Sum tree over bounded unsigned integers, storing every level in the narrowest integer width that can hold it.
+// Level k holds sums of up to 2^k leaves, so with a declared leaf bound its largest value is leafBound * 2^k,
+// e.g. for leaves up to 255 the lowest eight levels fit in 16 bits and only the top levels need 32 or 64.
+// Levels are laid out bottom up, level k holds ceil(count / 2^k) nodes with node j covering [j * 2^k, (j + 1) * 2^k).
+class CompressedSumTree
+{
+public:
+    // Every element must be at most leafBound
+    CompressedSumTree(std::span<const uint64_t> values, uint64_t leafBound);
+
+    // Sum of the elements in [left, right)
+    uint64_t Query(size_t left, size_t right) const;
+
+    // Sums are a group, so the difference is added along the path touching one node per level
+    void Update(size_t index, uint64_t newValue);
+
+    uint64_t operator[](size_t index) const;
+
+    size_t GetCount() const;
+    uint64_t GetLeafBound() const;
+
+    size_t GetLevelCount() const;
+
+    // Bytes per node of the given level, 1, 2, 4 or 8
+    size_t GetLevelWidth(size_t level) const;
+
+    // Bytes used by the node storage
+    size_t GetMemoryUsage() const;
+
+private:
+    struct Level
+    {
+        // Byte offset of the level in data
+        size_t offset;
+        size_t count;
+        size_t width;
+    };
+
+    std::vector<uint8_t> data;
+    std::vector<Level> levels;
+
+    size_t count;
+    uint64_t leafBound;
+
+    uint64_t Load(const Level& level, size_t i) const;
+    void Store(const Level& level, size_t i, uint64_t value);
+
+    static size_t GetWidth(uint64_t maxValue);
+};
+
+inline CompressedSumTree::CompressedSumTree(std::span<const uint64_t> values, uint64_t leafBound)
+    : count{ values.size() }
+    , leafBound{ leafBound }
+{
+    size_t offset = 0;
+    size_t levelCount = count;
+    uint64_t maxValue = leafBound;
+
+    while (true)
+    {
+        size_t width = GetWidth(maxValue);
+
+        // Align every level to its width, so loads never straddle a cache line
+        offset = (offset + width - 1) / width * width;
+        levels.push_back(Level{ offset, levelCount, width });
+        offset += levelCount * width;
+
+        if (levelCount <= 1)
+        {
+            break;
+        }
+
+        levelCount = (levelCount + 1) / 2;
+        maxValue = maxValue > UINT64_MAX / 2 ? UINT64_MAX : maxValue * 2;
+    }
+
+    data.resize(offset);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        assert(values[i] <= leafBound);
+        Store(levels[0], i, values[i]);
+    }
+
+    for (size_t k = 1; k < levels.size(); ++k)
+    {
+        const Level& below = levels[k - 1];
+        const Level& level = levels[k];
+
+        for (size_t j = 0; j < level.count; ++j)
+        {
+            uint64_t sum = Load(below, 2 * j);
+            if (2 * j + 1 < below.count)
+            {
+                sum += Load(below, 2 * j + 1);
+            }
+
+            Store(level, j, sum);
+        }
+    }
+}
+
+inline uint64_t CompressedSumTree::Query(size_t left, size_t right) const
+{
+    assert(left < right && right <= count);
+
+    uint64_t sum = 0;
+
+    for (size_t k = 0; left < right; ++k)
+    {
+        if (left & 1)
+        {
+            sum += Load(levels[k], left++);
+        }
+
+        if (right & 1)
+        {
+            sum += Load(levels[k], --right);
+        }
+
+        left /= 2;
+        right /= 2;
+    }
+
+    return sum;
+}
+
+inline void CompressedSumTree::Update(size_t index, uint64_t newValue)
+{
+    assert(index < count && newValue <= leafBound);
+
+    // Wrapping arithmetic is exact here, every stored sum fits its width
+    uint64_t delta = newValue - Load(levels[0], index);
+
+    for (size_t k = 0; k < levels.size(); ++k, index /= 2)
+    {
+        Store(levels[k], index, Load(levels[k], index) + delta);
+    }
+}
+
+inline uint64_t CompressedSumTree::operator[](size_t index) const
+{
+    return Load(levels[0], index);
+}
+
+inline size_t CompressedSumTree::GetCount() const
+{
+    return count;
+}
+
+inline uint64_t CompressedSumTree::GetLeafBound() const
+{
+    return leafBound;
+}
+
+inline size_t CompressedSumTree::GetLevelCount() const
+{
+    return levels.size();
+}
+
+inline size_t CompressedSumTree::GetLevelWidth(size_t level) const
+{
+    return levels[level].width;
+}
+
+inline size_t CompressedSumTree::GetMemoryUsage() const
+{
+    return data.size();
+}
+
+// memcpy keeps the narrow loads and stores free of aliasing and alignment issues, it compiles to a single move
+inline uint64_t CompressedSumTree::Load(const Level& level, size_t i) const
+{
+    const uint8_t* p = data.data() + level.offset + i * level.width;
+
+    switch (level.width)
+    {
+    case 1:
+        return *p;
+    case 2:
+    {
+        uint16_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+    case 4:
+    {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+    default:
+    {
+        uint64_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+    }
+}
+
+inline void CompressedSumTree::Store(const Level& level, size_t i, uint64_t value)
+{
+    uint8_t* p = data.data() + level.offset + i * level.width;
+
+    switch (level.width)
+    {
+    case 1:
+        *p = uint8_t(value);
+        break;
+    case 2:
+    {
+        uint16_t narrow = uint16_t(value);
+        std::memcpy(p, &narrow, sizeof(narrow));
+        break;
+    }
+    case 4:
+    {
+        uint32_t narrow = uint32_t(value);
+        std::memcpy(p, &narrow, sizeof(narrow));
+        break;
+    }
+    default:
+        std::memcpy(p, &value, sizeof(value));
+        break;
+    }
+}
+
+inline size_t CompressedSumTree::GetWidth(uint64_t maxValue)
+{
+    if (maxValue <= UINT8_MAX)
+    {
+        return 1;
+    }
+
+    if (maxValue <= UINT16_MAX)
+    {
+        return 2;
+    }
+
+    return maxValue <= UINT32_MAX ? 4 : 8;
+}
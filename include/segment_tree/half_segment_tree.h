@@ -0,0 +1,377 @@
+#pragma once
+
+#include "segment_tree.h"
+
+#include <algorithm>
+#include <bit>
+
+// Segment tree for commutative invertible combines (sums, xor) that stores only left children.
+// The right child of any node is its parent with the left child removed, so every right child and every leaf
+// can be derived on the way down, and the tree takes capacity values instead of 2 * capacity (Fenwick-like density).
+// tree[i] holds the aggregate of the left child of internal node i in the usual heap numbering, tree[0] holds the total.
+// Op combines two values and Inverse removes its second operand from the first, both are stateless function objects,
+// e.g. std::plus<> with std::minus<>, or std::bit_xor<> for both.
+template <typename T, typename Op, typename Inverse>
+class HalfSegmentTree
+{
+public:
+    HalfSegmentTree(std::span<const T> data, T noneValue);
+    ~HalfSegmentTree() noexcept;
+
+    HalfSegmentTree(const HalfSegmentTree& other);
+    HalfSegmentTree& operator=(const HalfSegmentTree& other);
+    HalfSegmentTree(HalfSegmentTree&& other) noexcept;
+    HalfSegmentTree& operator=(HalfSegmentTree&& other) noexcept;
+
+    // Combination over [left, right), the difference of two prefix descents
+    T Query(size_t left, size_t right) const;
+    // Combination over [0, right)
+    T PrefixQuery(size_t right) const;
+
+    void Update(size_t index, T newValue);
+    // Combines delta into the element at index
+    void Add(size_t index, T delta);
+    // Doubles the capacity when full, the old tree becomes the left subtree of the new root
+    void PushBack(T value);
+
+    // Smallest index whose inclusive prefix is not less than target, or GetCount() if there is none
+    // Requires every element to be non-negative, so that the prefixes are sorted
+    size_t LowerBound(const T& target) const;
+
+    T operator[](size_t index) const;
+
+    size_t GetCount() const;
+    size_t GetCapacity() const;
+    const T* GetTree() const;
+    T GetNoneValue() const;
+
+private:
+    // Left child aggregates, capacity of them, the total is stored in the first element
+    T* tree;
+
+    [[no_unique_address]] Op combineFcn;
+    [[no_unique_address]] Inverse inverseFcn;
+
+    T noneValue;
+
+    // Count of original elements
+    size_t count;
+
+    // Leaf capacity, a power of two
+    size_t capacity;
+
+    // Stores the left child aggregates of node, which covers the width elements starting at begin,
+    // and returns the aggregate of node
+    T Build(const T* data, size_t node, size_t begin, size_t width);
+};
+
+template <typename T, typename Op, typename Inverse>
+inline HalfSegmentTree<T, Op, Inverse>::HalfSegmentTree(std::span<const T> data, T noneValue)
+    : combineFcn{}
+    , inverseFcn{}
+    , noneValue{ noneValue }
+    , count{ data.size() }
+    , capacity{ std::bit_ceil(std::max(data.size(), size_t(1))) }
+{
+    // Read before the allocation, so the compiler can tell a single leaf never reaches Build
+    size_t leaves = capacity;
+
+    tree = new T[leaves];
+
+    // A single leaf has no left child aggregates, the total is all there is
+    if (leaves == 1)
+    {
+        tree[0] = data.empty() ? noneValue : data[0];
+    }
+    else
+    {
+        tree[0] = Build(data.data(), 1, 0, leaves);
+    }
+}
+
+template <typename T, typename Op, typename Inverse>
+inline HalfSegmentTree<T, Op, Inverse>::~HalfSegmentTree() noexcept
+{
+    delete[] tree;
+}
+
+template <typename T, typename Op, typename Inverse>
+inline HalfSegmentTree<T, Op, Inverse>::HalfSegmentTree(const HalfSegmentTree& other)
+{
+    noneValue = other.noneValue;
+    count = other.count;
+    capacity = other.capacity;
+
+    tree = new T[capacity];
+    std::copy(other.tree, other.tree + capacity, tree);
+}
+
+template <typename T, typename Op, typename Inverse>
+inline HalfSegmentTree<T, Op, Inverse>& HalfSegmentTree<T, Op, Inverse>::operator=(const HalfSegmentTree& other)
+{
+    if (this != &other)
+    {
+        delete[] tree;
+
+        noneValue = other.noneValue;
+        count = other.count;
+        capacity = other.capacity;
+
+        tree = new T[capacity];
+        std::copy(other.tree, other.tree + capacity, tree);
+    }
+
+    return *this;
+}
+
+template <typename T, typename Op, typename Inverse>
+inline HalfSegmentTree<T, Op, Inverse>::HalfSegmentTree(HalfSegmentTree&& other) noexcept
+{
+    tree = other.tree;
+    noneValue = other.noneValue;
+    count = other.count;
+    capacity = other.capacity;
+
+    other.tree = nullptr;
+    other.count = 0;
+    other.capacity = 0;
+}
+
+template <typename T, typename Op, typename Inverse>
+inline HalfSegmentTree<T, Op, Inverse>& HalfSegmentTree<T, Op, Inverse>::operator=(HalfSegmentTree&& other) noexcept
+{
+    if (this != &other)
+    {
+        delete[] tree;
+
+        tree = other.tree;
+        noneValue = other.noneValue;
+        count = other.count;
+        capacity = other.capacity;
+
+        other.tree = nullptr;
+        other.count = 0;
+        other.capacity = 0;
+    }
+
+    return *this;
+}
+
+template <typename T, typename Op, typename Inverse>
+inline T HalfSegmentTree<T, Op, Inverse>::Query(size_t left, size_t right) const
+{
+    assert(left < right && right <= count);
+
+    return inverseFcn(PrefixQuery(right), PrefixQuery(left));
+}
+
+template <typename T, typename Op, typename Inverse>
+inline T HalfSegmentTree<T, Op, Inverse>::PrefixQuery(size_t right) const
+{
+    assert(right <= count);
+
+    if (right == capacity)
+    {
+        return tree[0];
+    }
+
+    // The bits of right select the path, every step to the right skips a left child that lies entirely before right
+    T value = noneValue;
+    size_t node = 1;
+
+    for (size_t half = capacity / 2; half > 0; half /= 2)
+    {
+        bool toRight = (right & half) != 0;
+        if (toRight)
+        {
+            value = combineFcn(value, tree[node]);
+        }
+
+        node = 2 * node + toRight;
+    }
+
+    return value;
+}
+
+template <typename T, typename Op, typename Inverse>
+inline void HalfSegmentTree<T, Op, Inverse>::Update(size_t index, T newValue)
+{
+    assert(index < count);
+
+    // One descent derives the old leaf and records the left children on the path, which then take the delta
+    size_t path[64];
+    size_t pathLength = 0;
+
+    T value = tree[0];
+    size_t node = 1;
+
+    for (size_t half = capacity / 2; half > 0; half /= 2)
+    {
+        bool toRight = (index & half) != 0;
+        value = toRight ? inverseFcn(value, tree[node]) : tree[node];
+
+        path[pathLength] = node;
+        pathLength += !toRight;
+
+        node = 2 * node + toRight;
+    }
+
+    T delta = inverseFcn(newValue, value);
+
+    tree[0] = combineFcn(tree[0], delta);
+    for (size_t i = 0; i < pathLength; ++i)
+    {
+        tree[path[i]] = combineFcn(tree[path[i]], delta);
+    }
+}
+
+template <typename T, typename Op, typename Inverse>
+inline void HalfSegmentTree<T, Op, Inverse>::Add(size_t index, T delta)
+{
+    assert(index < count);
+
+    // The bits of index select the path, only the left children on it change, right children are derived
+    tree[0] = combineFcn(tree[0], delta);
+
+    size_t node = 1;
+
+    for (size_t half = capacity / 2; half > 0; half /= 2)
+    {
+        bool toRight = (index & half) != 0;
+        if (!toRight)
+        {
+            tree[node] = combineFcn(tree[node], delta);
+        }
+
+        node = 2 * node + toRight;
+    }
+}
+
+template <typename T, typename Op, typename Inverse>
+inline void HalfSegmentTree<T, Op, Inverse>::PushBack(T value)
+{
+    if (count == capacity)
+    {
+        T* newTree = new T[capacity * 2];
+        std::fill(newTree, newTree + capacity * 2, noneValue);
+
+        // Node i at depth d moves one level down into the left subtree, keeping its position within the level
+        newTree[0] = tree[0];
+        newTree[1] = tree[0];
+
+        for (size_t i = 1; i < capacity; ++i)
+        {
+            newTree[i + std::bit_floor(i)] = tree[i];
+        }
+
+        delete[] tree;
+        tree = newTree;
+        capacity *= 2;
+    }
+
+    ++count;
+    Add(count - 1, inverseFcn(value, noneValue));
+}
+
+template <typename T, typename Op, typename Inverse>
+inline size_t HalfSegmentTree<T, Op, Inverse>::LowerBound(const T& target) const
+{
+    if (tree[0] < target)
+    {
+        return count;
+    }
+
+    // Descends into the right child whenever the prefix up to the end of the left child is still short
+    T value = noneValue;
+    size_t node = 1;
+    size_t begin = 0;
+
+    for (size_t half = capacity / 2; half > 0; half /= 2)
+    {
+        T next = combineFcn(value, tree[node]);
+
+        if (next < target)
+        {
+            value = next;
+            begin += half;
+            node = 2 * node + 1;
+        }
+        else
+        {
+            node = 2 * node;
+        }
+    }
+
+    return begin;
+}
+
+template <typename T, typename Op, typename Inverse>
+inline T HalfSegmentTree<T, Op, Inverse>::operator[](size_t index) const
+{
+    assert(index < count);
+
+    // The leaf is derived from its ancestors, a right child is its parent without the left sibling
+    T value = tree[0];
+    size_t node = 1;
+
+    for (size_t half = capacity / 2; half > 0; half /= 2)
+    {
+        bool toRight = (index & half) != 0;
+        value = toRight ? inverseFcn(value, tree[node]) : tree[node];
+        node = 2 * node + toRight;
+    }
+
+    return value;
+}
+
+template <typename T, typename Op, typename Inverse>
+inline size_t HalfSegmentTree<T, Op, Inverse>::GetCount() const
+{
+    return count;
+}
+
+template <typename T, typename Op, typename Inverse>
+inline size_t HalfSegmentTree<T, Op, Inverse>::GetCapacity() const
+{
+    return capacity;
+}
+
+template <typename T, typename Op, typename Inverse>
+inline const T* HalfSegmentTree<T, Op, Inverse>::GetTree() const
+{
+    return tree;
+}
+
+template <typename T, typename Op, typename Inverse>
+inline T HalfSegmentTree<T, Op, Inverse>::GetNoneValue() const
+{
+    return noneValue;
+}
+
+template <typename T, typename Op, typename Inverse>
+inline T HalfSegmentTree<T, Op, Inverse>::Build(const T* data, size_t node, size_t begin, size_t width)
+{
+    if (width == 1)
+    {
+        return begin < count ? data[begin] : noneValue;
+    }
+
+    if (begin >= count)
+    {
+        // Subtrees past the end hold only padding
+        for (size_t level = node, levelWidth = 1; level < capacity; level *= 2, levelWidth *= 2)
+        {
+            std::fill(tree + level, tree + level + levelWidth, noneValue);
+        }
+
+        return noneValue;
+    }
+
+    size_t half = width / 2;
+
+    T left = Build(data, 2 * node, begin, half);
+    T right = Build(data, 2 * node + 1, begin + half, half);
+
+    tree[node] = left;
+    return combineFcn(left, right);
+}
@@ -0,0 +1,322 @@
+#pragma once
+
+#include "segment_tree.h"
+
+#include <algorithm>
+#include <array>
+
+// K segment trees (columns) over the same index space, sharing one tree walk.
+// Each node stores its K values contiguously, so one Update or Query visits every column at once,
+// and the per-node combine is a fixed-length loop over the columns that the compiler can vectorize.
+// Op is a stateless function object such as std::plus<>.
+template <typename T, size_t K, typename Op>
+class MultiSegmentTree
+{
+    static_assert(K > 0, "MultiSegmentTree requires at least one column");
+
+public:
+    using Row = std::array<T, K>;
+
+    // Every element starts as noneValue
+    MultiSegmentTree(size_t count, const Row& noneValue);
+    MultiSegmentTree(std::span<const Row> data, const Row& noneValue);
+    ~MultiSegmentTree() noexcept;
+
+    MultiSegmentTree(const MultiSegmentTree& other);
+    MultiSegmentTree& operator=(const MultiSegmentTree& other);
+    MultiSegmentTree(MultiSegmentTree&& other) noexcept;
+    MultiSegmentTree& operator=(MultiSegmentTree&& other) noexcept;
+
+    // Combination over [left, right) of every column
+    Row Query(size_t left, size_t right) const;
+    // Combination over [left, right) of a single column
+    T Query(size_t left, size_t right, size_t column) const;
+
+    void Update(size_t index, const Row& newValue);
+    void Update(size_t index, size_t column, T newValue);
+
+    Row operator[](size_t index) const;
+
+    size_t GetCount() const;
+    size_t GetTreeSize() const;
+
+    // The K values of node i
+    const T* GetNode(size_t i) const;
+
+private:
+    // Internal tree array of size * K values, node i occupies [i * K, i * K + K)
+    // Root starts from node 1
+    // noneValue is stored in the first node
+    T* tree;
+
+    [[no_unique_address]] Op combineFcn;
+
+    // Count of original elements in the tree
+    size_t count;
+
+    // Number of nodes in the tree
+    size_t size;
+
+    T* Node(size_t i);
+    const T* Node(size_t i) const;
+
+    // out[k] = combineFcn(a[k], b[k]) for every column
+    void CombineRow(T* out, const T* a, const T* b) const;
+
+    void Build();
+};
+
+template <typename T, size_t K, typename Op>
+inline MultiSegmentTree<T, K, Op>::MultiSegmentTree(size_t count, const Row& noneValue)
+    : combineFcn{}
+    , count{ count }
+    , size{ compute_size(count) }
+{
+    tree = new T[size * K];
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        std::copy(noneValue.begin(), noneValue.end(), Node(i));
+    }
+}
+
+template <typename T, size_t K, typename Op>
+inline MultiSegmentTree<T, K, Op>::MultiSegmentTree(std::span<const Row> data, const Row& noneValue)
+    : combineFcn{}
+    , count{ data.size() }
+    , size{ compute_size(data.size()) }
+{
+    tree = new T[size * K];
+
+    std::copy(noneValue.begin(), noneValue.end(), Node(0));
+
+    size_t mid = size / 2;
+    size_t i = 0;
+
+    for (; i < count; ++i)
+    {
+        std::copy(data[i].begin(), data[i].end(), Node(mid + i));
+    }
+
+    for (i += mid; i < size; ++i)
+    {
+        std::copy(noneValue.begin(), noneValue.end(), Node(i));
+    }
+
+    Build();
+}
+
+template <typename T, size_t K, typename Op>
+inline MultiSegmentTree<T, K, Op>::~MultiSegmentTree() noexcept
+{
+    delete[] tree;
+}
+
+template <typename T, size_t K, typename Op>
+inline MultiSegmentTree<T, K, Op>::MultiSegmentTree(const MultiSegmentTree& other)
+{
+    count = other.count;
+    size = other.size;
+
+    tree = new T[size * K];
+    std::copy(other.tree, other.tree + size * K, tree);
+}
+
+template <typename T, size_t K, typename Op>
+inline MultiSegmentTree<T, K, Op>& MultiSegmentTree<T, K, Op>::operator=(const MultiSegmentTree& other)
+{
+    if (this != &other)
+    {
+        delete[] tree;
+
+        count = other.count;
+        size = other.size;
+
+        tree = new T[size * K];
+        std::copy(other.tree, other.tree + size * K, tree);
+    }
+
+    return *this;
+}
+
+template <typename T, size_t K, typename Op>
+inline MultiSegmentTree<T, K, Op>::MultiSegmentTree(MultiSegmentTree&& other) noexcept
+{
+    tree = other.tree;
+    count = other.count;
+    size = other.size;
+
+    other.tree = nullptr;
+    other.count = 0;
+    other.size = 0;
+}
+
+template <typename T, size_t K, typename Op>
+inline MultiSegmentTree<T, K, Op>& MultiSegmentTree<T, K, Op>::operator=(MultiSegmentTree&& other) noexcept
+{
+    if (this != &other)
+    {
+        delete[] tree;
+
+        tree = other.tree;
+        count = other.count;
+        size = other.size;
+
+        other.tree = nullptr;
+        other.count = 0;
+        other.size = 0;
+    }
+
+    return *this;
+}
+
+template <typename T, size_t K, typename Op>
+inline auto MultiSegmentTree<T, K, Op>::Query(size_t left, size_t right) const -> Row
+{
+    assert(left < right && right <= count);
+
+    left += size / 2;
+    right += size / 2 - 1;
+
+    Row leftValue;
+    Row rightValue;
+    std::copy(Node(0), Node(0) + K, leftValue.begin());
+    std::copy(Node(0), Node(0) + K, rightValue.begin());
+
+    while (left <= right)
+    {
+        if (left & 1)
+        {
+            CombineRow(leftValue.data(), leftValue.data(), Node(left));
+        }
+
+        if (~right & 1)
+        {
+            CombineRow(rightValue.data(), Node(right), rightValue.data());
+        }
+
+        left = (left + 1) / 2;
+        right = (right - 1) / 2;
+    }
+
+    CombineRow(leftValue.data(), leftValue.data(), rightValue.data());
+    return leftValue;
+}
+
+template <typename T, size_t K, typename Op>
+inline T MultiSegmentTree<T, K, Op>::Query(size_t left, size_t right, size_t column) const
+{
+    assert(left < right && right <= count && column < K);
+
+    left += size / 2;
+    right += size / 2 - 1;
+
+    T leftValue = Node(0)[column];
+    T rightValue = Node(0)[column];
+
+    while (left <= right)
+    {
+        if (left & 1)
+        {
+            leftValue = combineFcn(leftValue, Node(left)[column]);
+        }
+
+        if (~right & 1)
+        {
+            rightValue = combineFcn(Node(right)[column], rightValue);
+        }
+
+        left = (left + 1) / 2;
+        right = (right - 1) / 2;
+    }
+
+    return combineFcn(leftValue, rightValue);
+}
+
+template <typename T, size_t K, typename Op>
+inline void MultiSegmentTree<T, K, Op>::Update(size_t index, const Row& newValue)
+{
+    assert(index < count);
+
+    size_t i = size / 2 + index;
+
+    std::copy(newValue.begin(), newValue.end(), Node(i));
+
+    while (i > 1)
+    {
+        i /= 2;
+        CombineRow(Node(i), Node(2 * i), Node(2 * i + 1));
+    }
+}
+
+template <typename T, size_t K, typename Op>
+inline void MultiSegmentTree<T, K, Op>::Update(size_t index, size_t column, T newValue)
+{
+    assert(index < count && column < K);
+
+    size_t i = size / 2 + index;
+
+    Node(i)[column] = newValue;
+
+    while (i > 1)
+    {
+        i /= 2;
+        Node(i)[column] = combineFcn(Node(2 * i)[column], Node(2 * i + 1)[column]);
+    }
+}
+
+template <typename T, size_t K, typename Op>
+inline auto MultiSegmentTree<T, K, Op>::operator[](size_t index) const -> Row
+{
+    Row row;
+    std::copy(Node(size / 2 + index), Node(size / 2 + index) + K, row.begin());
+    return row;
+}
+
+template <typename T, size_t K, typename Op>
+inline size_t MultiSegmentTree<T, K, Op>::GetCount() const
+{
+    return count;
+}
+
+template <typename T, size_t K, typename Op>
+inline size_t MultiSegmentTree<T, K, Op>::GetTreeSize() const
+{
+    return size;
+}
+
+template <typename T, size_t K, typename Op>
+inline const T* MultiSegmentTree<T, K, Op>::GetNode(size_t i) const
+{
+    return Node(i);
+}
+
+template <typename T, size_t K, typename Op>
+inline T* MultiSegmentTree<T, K, Op>::Node(size_t i)
+{
+    return tree + i * K;
+}
+
+template <typename T, size_t K, typename Op>
+inline const T* MultiSegmentTree<T, K, Op>::Node(size_t i) const
+{
+    return tree + i * K;
+}
+
+template <typename T, size_t K, typename Op>
+inline void MultiSegmentTree<T, K, Op>::CombineRow(T* out, const T* a, const T* b) const
+{
+    for (size_t k = 0; k < K; ++k)
+    {
+        out[k] = combineFcn(a[k], b[k]);
+    }
+}
+
+template <typename T, size_t K, typename Op>
+inline void MultiSegmentTree<T, K, Op>::Build()
+{
+    for (size_t i = size / 2 - 1; i > 0; --i)
+    {
+        CombineRow(Node(i), Node(2 * i), Node(2 * i + 1));
+    }
+}
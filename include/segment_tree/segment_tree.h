@@ -1,25 +1,64 @@
 #pragma once
 
+#include <algorithm>
+#include <bit>
+#include <concepts>
 #include <cassert>
-#include <cmath>
+#include <iterator>
+#include <memory>
 #include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
-inline size_t compute_size(size_t n)
+#include "segment_tree_memory.h"
+#include "segment_tree_stats.h"
+
+// Twice the smallest power of two that can hold n leaves
+constexpr size_t compute_size(size_t n)
 {
-    size_t exp = size_t(std::log2(n - 1)) + 2;
-    return size_t(std::pow(2, exp));
+    return std::bit_ceil(n) * 2;
+}
+
+// Hints that the cache line holding p is about to be read (or written), a no-op where unsupported
+inline void prefetch_line(const void* p, bool write = false)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    if (write)
+    {
+        __builtin_prefetch(p, 1);
+    }
+    else
+    {
+        __builtin_prefetch(p, 0);
+    }
+#else
+    (void)p;
+    (void)write;
+#endif
 }
 
 // Templated class implementation of a segment tree,
 // which is a commonly used data structure for efficient range queries on arrays.
-template <typename T>
+// Stats is the instrumentation policy, see segment_tree_stats.h
+template <typename T, typename Stats = NoStats>
 class SegmentTree
 {
+    // New nodes are constructed from copies of noneValue or of a child, and queries return values by copy
+    static_assert(std::is_copy_constructible_v<T>, "SegmentTree requires a copy constructible T");
+
     typedef T Combine(T, T);
+    typedef void CombineInto(T&, const T&, const T&);
+    typedef T Inverse(T, T);
 
 public:
-    SegmentTree(std::span<T> data, Combine* combineFcn, T noneValue);
-    SegmentTree(std::initializer_list<T> data, Combine* combineFcn, T noneValue);
+    SegmentTree(std::span<T> data, Combine* combineFcn, T noneValue, const MemoryOptions& memory = {});
+    SegmentTree(std::initializer_list<T> data, Combine* combineFcn, T noneValue, const MemoryOptions& memory = {});
+
+    // combineIntoFcn(out, a, b) stores the combination of a and b in out without copying its operands,
+    // for large aggregates. out may be the same object as a or b.
+    SegmentTree(std::span<T> data, CombineInto* combineIntoFcn, T noneValue, const MemoryOptions& memory = {});
+    SegmentTree(std::initializer_list<T> data, CombineInto* combineIntoFcn, T noneValue, const MemoryOptions& memory = {});
     ~SegmentTree() noexcept;
 
     SegmentTree(const SegmentTree& other);
@@ -28,175 +67,344 @@ public:
     SegmentTree& operator=(SegmentTree&& other) noexcept;
 
     T Query(size_t left, size_t right) const;
-    void Update(size_t index, T newValue);
+    T QueryBranchless(size_t left, size_t right) const
+        requires std::is_arithmetic_v<T>;
+    T PrefixQuery(size_t right) const;
+    T SuffixQuery(size_t left) const;
+    void Update(size_t index, const T& newValue);
+    void Update(size_t index, T&& newValue);
+
+    // Replaces the element at index with T(args...), which is moved into the leaf
+    template <typename... Args>
+    void Emplace(size_t index, Args&&... args);
+
+    // Combines delta into the element at index, the combine function must be commutative (e.g. sum, xor, min, max)
+    // Only one node per level is touched, and for trivially copyable T the walk stops at the first node that does not change.
+    void Add(size_t index, T delta);
     void Insert(size_t index, T value);
+    void InsertRange(size_t index, std::span<const T> values);
     void PushBack(T value);
 
+    // Removes elements and shifts the tail left like std::vector::erase, then rebuilds the nodes above the shifted leaves,
+    // so the cost is O(count - left) as with Insert rather than amortized O(log n).
+    // Erased slots are not kept as tombstones compacted in batches: an index would then no longer address its leaf,
+    // and every Update, Query and operator[] would pay a rank search over live counts to find it.
+    // The tree array shrinks once at most a quarter of its leaf slots (size / 2, not the capacity) are in use.
+    void Erase(size_t index);
+    void EraseRange(size_t left, size_t right);
+    // O(log n), nothing is shifted
+    void PopBack();
+
+    void Reserve(size_t capacity);
+    void ShrinkToFit();
+
+    // Declares the inverse of a commutative combine function (e.g. subtraction for sum),
+    // Update then adds the difference to the old value through the same walk as Add.
+    // Exact for integer groups, with floating point the ancestors accumulate rounding error over many updates.
+    void SetInverse(Inverse* inverseFcn);
+
+    void EnablePrefixCache(Inverse* inverseFcn);
+    void DisablePrefixCache();
+
+    // Prefetches every node below the hot top on the path of an Update or Query before walking it,
+    // so that the cache misses on large trees overlap instead of forming a dependent chain
+    void EnablePrefetch();
+    void DisablePrefetch();
+
     T operator[](size_t index) const;
 
     size_t GetCount() const;
+    size_t GetCapacity() const;
     const T* GetTree() const;
+
+    // Length of the index space of the tree array, nodes are addressed in [0, GetTreeSize()).
+    // Not every index is backed by memory, leaf slots past the capacity are not allocated,
+    // use GetAllocatedBytes for the memory footprint.
     size_t GetTreeSize() const;
+
+    // Bytes requested for the tree array: the internal nodes and the allocated leaf slots
+    size_t GetAllocatedBytes() const;
+
     T GetNoneValue() const;
+    const MemoryOptions& GetMemoryOptions() const;
+
+    SegmentTreeStats GetStats() const
+        requires Stats::enabled;
+    void ResetStats()
+        requires Stats::enabled;
 
 private:
     // Internal tree array
     // Root starts from index 1
     // nonValue is stored in the first element
+    // Leaves past count and the internal nodes whose range starts past count are never constructed,
+    // they act as noneValue without being read, and only capacity leaf slots are allocated after the internal nodes.
     T* tree;
 
-    // Combine function
-    Combine* combineFcn;
+    // Combine function, exactly one of the two is set
+    Combine* combineFcn = nullptr;
+    CombineInto* combineIntoFcn = nullptr;
+
+    // inverseFcn(a, b) returns the x that satisfies combineFcn(b, x) == a, nullptr unless declared
+    Inverse* inverseFcn = nullptr;
 
     // Count of original elements in the tree
     size_t count;
 
-    // Size of the segment tree array
+    // Size of the segment tree array, as if every leaf slot was stored
     size_t size;
 
+    // Number of allocated leaf slots, count <= capacity <= size / 2
+    size_t capacity;
+
+    // Page backing and NUMA placement of the tree array, kept for every reallocation
+    MemoryOptions memory;
+
+    bool prefetch = false;
+
+    // The top levels, nodes [1, hotTopNodes), form one contiguous block of about 256KB.
+    // Every walk passes through it so it stays cache resident and is never prefetched.
+    static constexpr size_t hotTopNodes = std::bit_floor(std::max(size_t(2), (size_t(256) << 10) / sizeof(T)));
+
+    // Instrumentation policy, empty unless enabled
+    [[no_unique_address]] mutable Stats stats;
+
+    struct PrefixCache
+    {
+        // inverseFcn(a, b) returns the x that satisfies combineFcn(b, x) == a
+        Inverse* inverseFcn;
+
+        // values[i] holds the combination of the first i elements
+        std::vector<T> values;
+
+        // Cleared by every modification, the values are recomputed on the next prefix query
+        bool valid;
+    };
+
+    // Cached prefix combinations, nullptr unless enabled
+    mutable PrefixCache* prefixCache = nullptr;
+
     size_t GetLeft(size_t i) const;
     size_t GetRight(size_t i) const;
     size_t GetParent(size_t i) const;
+
+    T* AllocateTree(size_t n) const;
+    void FreeTree(T* p, size_t size, size_t capacity, size_t count) const noexcept;
+    template <typename F>
+    void ForEachStoredRun(size_t size, size_t count, F f) const;
+    void ConstructNode(size_t i, size_t childEnd);
+    void ConstructInternalNodes();
+    void ConstructStoredNodes(size_t newCount);
+    void DestroyStoredNodes(size_t newCount);
+    void Initialize(const T* data, const T& noneValue);
+    void Merge(T& out, const T& left, const T& right) const;
+    void InvalidatePrefixCache();
+    const std::vector<T>& GetPrefixCache() const;
+    void PrefetchPath(size_t i) const;
+    bool MergeChanged(T& out, const T& left, const T& right) const;
+    bool RecomputeNode(size_t i, size_t childEnd);
+    const T& GetChild(size_t i, size_t childEnd) const;
+    void UpdateAncestors(size_t i);
+    void Propagate(size_t i, const T& delta);
+    template <typename U>
+    void Replace(size_t index, U&& value);
+    template <typename U>
+    void Assign(size_t index, U&& value);
+    template <typename It>
+    void InsertRun(size_t index, It first, size_t inserted);
+    size_t GetGrownCapacity(size_t newSize, size_t newCount) const;
+    void Resize(size_t newSize, size_t newCapacity);
+    void Rebuild(size_t begin, size_t end);
+    void ShrinkIfSparse();
 };
 
-template <typename T>
-inline SegmentTree<T>::SegmentTree(std::span<T> data, Combine* combineFcn, T noneValue)
+template <typename T, typename Stats>
+inline SegmentTree<T, Stats>::SegmentTree(std::span<T> data, Combine* combineFcn, T noneValue, const MemoryOptions& memory)
     : combineFcn{ combineFcn }
     , count{ data.size() }
     , size{ compute_size(data.size()) }
+    , capacity{ data.size() }
+    , memory{ memory }
 {
-    tree = new T[size];
-    tree[0] = noneValue;
-
-    size_t mid = size / 2;
-    size_t i = 0;
-
-    for (; i < count; ++i)
-    {
-        tree[mid + i] = data[i];
-    }
-
-    for (i += mid; i < size; ++i)
-    {
-        tree[i] = noneValue;
-    }
-
-    i = mid - 1;
-    while (i > 0)
-    {
-        tree[i] = combineFcn(tree[GetLeft(i)], tree[GetRight(i)]);
-        --i;
-    }
+    Initialize(data.data(), noneValue);
 }
 
-template <typename T>
-inline SegmentTree<T>::SegmentTree(std::initializer_list<T> data, Combine* combineFcn, T noneValue)
+template <typename T, typename Stats>
+inline SegmentTree<T, Stats>::SegmentTree(std::initializer_list<T> data,
+                                          Combine* combineFcn,
+                                          T noneValue,
+                                          const MemoryOptions& memory)
     : combineFcn{ combineFcn }
     , count{ data.size() }
     , size{ compute_size(data.size()) }
+    , capacity{ data.size() }
+    , memory{ memory }
 {
-    tree = new T[size];
-    tree[0] = noneValue;
-
-    size_t mid = size / 2;
-    size_t i = 0;
-
-    for (; i < count; ++i)
-    {
-        tree[mid + i] = *(data.begin() + i);
-    }
+    Initialize(data.begin(), noneValue);
+}
 
-    for (i += mid; i < size; ++i)
-    {
-        tree[i] = noneValue;
-    }
+template <typename T, typename Stats>
+inline SegmentTree<T, Stats>::SegmentTree(std::span<T> data,
+                                          CombineInto* combineIntoFcn,
+                                          T noneValue,
+                                          const MemoryOptions& memory)
+    : combineIntoFcn{ combineIntoFcn }
+    , count{ data.size() }
+    , size{ compute_size(data.size()) }
+    , capacity{ data.size() }
+    , memory{ memory }
+{
+    Initialize(data.data(), noneValue);
+}
 
-    i = mid - 1;
-    while (i > 0)
-    {
-        tree[i] = combineFcn(tree[GetLeft(i)], tree[GetRight(i)]);
-        --i;
-    }
+template <typename T, typename Stats>
+inline SegmentTree<T, Stats>::SegmentTree(std::initializer_list<T> data,
+                                          CombineInto* combineIntoFcn,
+                                          T noneValue,
+                                          const MemoryOptions& memory)
+    : combineIntoFcn{ combineIntoFcn }
+    , count{ data.size() }
+    , size{ compute_size(data.size()) }
+    , capacity{ data.size() }
+    , memory{ memory }
+{
+    Initialize(data.begin(), noneValue);
 }
 
-template <typename T>
-inline SegmentTree<T>::~SegmentTree() noexcept
+template <typename T, typename Stats>
+inline SegmentTree<T, Stats>::~SegmentTree() noexcept
 {
-    delete[] tree;
+    FreeTree(tree, size, capacity, count);
+    delete prefixCache;
 }
 
-template <typename T>
-inline SegmentTree<T>::SegmentTree(const SegmentTree& other)
+template <typename T, typename Stats>
+inline SegmentTree<T, Stats>::SegmentTree(const SegmentTree& other)
 {
     combineFcn = other.combineFcn;
+    combineIntoFcn = other.combineIntoFcn;
+    inverseFcn = other.inverseFcn;
     count = other.count;
     size = other.size;
-
-    tree = new T[size];
-    memcpy(tree, other.tree, size * sizeof(T));
+    capacity = other.capacity;
+    memory = other.memory;
+    prefetch = other.prefetch;
+    stats = other.stats;
+    prefixCache = other.prefixCache ? new PrefixCache{ *other.prefixCache } : nullptr;
+
+    tree = AllocateTree(size / 2 + capacity);
+    ForEachStoredRun(size, count, [&](size_t begin, size_t end) {
+        std::uninitialized_copy(other.tree + begin, other.tree + end, tree + begin);
+    });
 }
 
-template <typename T>
-inline SegmentTree<T>& SegmentTree<T>::operator=(const SegmentTree& other)
+template <typename T, typename Stats>
+inline SegmentTree<T, Stats>& SegmentTree<T, Stats>::operator=(const SegmentTree& other)
 {
     if (this != &other)
     {
-        delete[] tree;
+        FreeTree(tree, size, capacity, count);
+        delete prefixCache;
 
         combineFcn = other.combineFcn;
+        combineIntoFcn = other.combineIntoFcn;
+        inverseFcn = other.inverseFcn;
         count = other.count;
         size = other.size;
-
-        tree = new T[size];
-        memcpy(tree, other.tree, size * sizeof(T));
+        capacity = other.capacity;
+        memory = other.memory;
+        prefetch = other.prefetch;
+        stats = other.stats;
+        prefixCache = other.prefixCache ? new PrefixCache{ *other.prefixCache } : nullptr;
+
+        tree = AllocateTree(size / 2 + capacity);
+        ForEachStoredRun(size, count, [&](size_t begin, size_t end) {
+            std::uninitialized_copy(other.tree + begin, other.tree + end, tree + begin);
+        });
     }
 
     return *this;
 }
 
-template <typename T>
-inline SegmentTree<T>::SegmentTree(SegmentTree&& other) noexcept
+template <typename T, typename Stats>
+inline SegmentTree<T, Stats>::SegmentTree(SegmentTree&& other) noexcept
 {
     tree = other.tree;
     combineFcn = other.combineFcn;
+    combineIntoFcn = other.combineIntoFcn;
+    inverseFcn = other.inverseFcn;
     count = other.count;
     size = other.size;
+    capacity = other.capacity;
+    memory = other.memory;
+    prefetch = other.prefetch;
+    stats = other.stats;
+    prefixCache = other.prefixCache;
 
     other.tree = nullptr;
     other.combineFcn = nullptr;
+    other.combineIntoFcn = nullptr;
+    other.inverseFcn = nullptr;
     other.count = 0;
     other.size = 0;
+    other.capacity = 0;
+    other.prefixCache = nullptr;
 }
 
-template <typename T>
-inline SegmentTree<T>& SegmentTree<T>::operator=(SegmentTree&& other) noexcept
+template <typename T, typename Stats>
+inline SegmentTree<T, Stats>& SegmentTree<T, Stats>::operator=(SegmentTree&& other) noexcept
 {
     if (this != &other)
     {
-        delete[] tree;
+        FreeTree(tree, size, capacity, count);
+        delete prefixCache;
 
         tree = other.tree;
         combineFcn = other.combineFcn;
+        combineIntoFcn = other.combineIntoFcn;
+        inverseFcn = other.inverseFcn;
         count = other.count;
         size = other.size;
+        capacity = other.capacity;
+        memory = other.memory;
+        prefetch = other.prefetch;
+        stats = other.stats;
+        prefixCache = other.prefixCache;
 
         other.tree = nullptr;
         other.combineFcn = nullptr;
+        other.combineIntoFcn = nullptr;
+        other.inverseFcn = nullptr;
         other.count = 0;
         other.size = 0;
+        other.capacity = 0;
+        other.prefixCache = nullptr;
     }
 
     return *this;
 }
 
-template <typename T>
-inline T SegmentTree<T>::Query(size_t left, size_t right) const
+template <typename T, typename Stats>
+inline T SegmentTree<T, Stats>::Query(size_t left, size_t right) const
 {
-    assert(left < right);
+    // The walk only visits nodes inside [left, right), so the padding is never read
+    assert(left < right && right <= count);
+
+    typename Stats::Timer timer{ stats, StatsOperation::Query };
 
     left += size / 2;
     right += size / 2 - 1;
 
+    if (prefetch)
+    {
+        // Same boundaries as the walk below, both stay on one level so only the left one is checked
+        for (size_t l = left, r = right; l <= r && l >= hotTopNodes; l = GetParent(l + 1), r = GetParent(r - 1))
+        {
+            prefetch_line(tree + l);
+            prefetch_line(tree + r);
+        }
+    }
+
     T leftValue = GetNoneValue();
     T rightValue = GetNoneValue();
 
@@ -204,161 +412,864 @@ inline T SegmentTree<T>::Query(size_t left, size_t right) const
     {
         if (left & 1)
         {
-            leftValue = combineFcn(leftValue, tree[left]);
+            Merge(leftValue, leftValue, tree[left]);
         }
 
         if (~right & 1)
         {
-            rightValue = combineFcn(tree[right], rightValue);
+            Merge(rightValue, tree[right], rightValue);
         }
 
         left = GetParent(left + 1);
         right = GetParent(right - 1);
     }
 
-    return combineFcn(leftValue, rightValue);
+    Merge(leftValue, leftValue, rightValue);
+    return leftValue;
 }
 
-template <typename T>
-inline void SegmentTree<T>::Update(size_t index, T newValue)
+// Same as Query, but the boundary nodes are selected instead of branched on.
+// Combining with noneValue leaves a value unchanged, so both sides are combined at every level.
+// The selects compile to conditional moves, which avoids the mispredictions on random ranges.
+template <typename T, typename Stats>
+inline T SegmentTree<T, Stats>::QueryBranchless(size_t left, size_t right) const
+    requires std::is_arithmetic_v<T>
 {
-    size_t i = size / 2 + index;
+    assert(left < right && right <= count);
 
-    tree[i] = newValue;
+    typename Stats::Timer timer{ stats, StatsOperation::Query };
 
-    while (i > 1)
+    left += size / 2;
+    right += size / 2 - 1;
+
+    T none = GetNoneValue();
+    T leftValue = none;
+    T rightValue = none;
+
+    while (left <= right)
     {
-        size_t parentIndex = GetParent(i);
-        tree[parentIndex] = combineFcn(tree[GetLeft(parentIndex)], tree[GetRight(parentIndex)]);
-        i = parentIndex;
+        T l = tree[left];
+        T r = tree[right];
+
+        Merge(leftValue, leftValue, (left & 1) ? l : none);
+        Merge(rightValue, (right & 1) ? none : r, rightValue);
+
+        left = GetParent(left + 1);
+        right = GetParent(right - 1);
     }
+
+    Merge(leftValue, leftValue, rightValue);
+    return leftValue;
 }
 
-template <typename T>
-inline void SegmentTree<T>::Insert(size_t index, T value)
+// Combination of the elements [0, right), walking only the right boundary
+// O(1) while the prefix cache is enabled and no modification happened since the last prefix query
+template <typename T, typename Stats>
+inline T SegmentTree<T, Stats>::PrefixQuery(size_t right) const
 {
-    assert(0 <= index && index <= size / 2);
+    assert(right <= count);
+
+    typename Stats::Timer timer{ stats, StatsOperation::Query };
 
-    if (count == size / 2)
+    if (prefixCache)
     {
-        T* old = tree;
-        tree = new T[size * 2];
-        tree[0] = old[0];
+        return GetPrefixCache()[right];
+    }
+
+    if (right == count && count > 0)
+    {
+        return tree[1];
+    }
 
-        memcpy(tree + size, old + size / 2, size / 2 * sizeof(T));
+    // Exclusive end, stops once it reaches the first node of a level
+    size_t end = size / 2 + right;
+    T value = GetNoneValue();
 
-        for (size_t i = 0; i < size / 2; ++i)
+    while (end & (end - 1))
+    {
+        if (end & 1)
         {
-            tree[size + size / 2 + i] = old[0];
+            Merge(value, tree[end - 1], value);
         }
 
-        delete[] old;
+        end = GetParent(end);
+    }
 
-        size *= 2;
+    return value;
+}
+
+// Combination of the elements [left, count), walking only the left boundary
+template <typename T, typename Stats>
+inline T SegmentTree<T, Stats>::SuffixQuery(size_t left) const
+{
+    assert(left <= count);
+
+    typename Stats::Timer timer{ stats, StatsOperation::Query };
+
+    if (prefixCache)
+    {
+        const std::vector<T>& prefix = GetPrefixCache();
+        return prefixCache->inverseFcn(prefix[count], prefix[left]);
     }
 
-    size_t mid = size / 2;
-    size_t ptr = count;
+    if (left == 0 && count > 0)
+    {
+        return tree[1];
+    }
+
+    // Stops once it moves past the last stored node of a level
+    size_t begin = size / 2 + left;
+    size_t end = size / 2 + count;
+    T value = GetNoneValue();
+
+    while (begin < end)
+    {
+        if (begin & 1)
+        {
+            Merge(value, value, tree[begin]);
+            ++begin;
+        }
+
+        begin = GetParent(begin);
+        end = GetParent(end + 1);
+    }
+
+    return value;
+}
+
+template <typename T, typename Stats>
+inline void SegmentTree<T, Stats>::Update(size_t index, const T& newValue)
+{
+    assert(index < count);
+
+    typename Stats::Timer timer{ stats, StatsOperation::Update };
+
+    Replace(index, newValue);
+}
+
+template <typename T, typename Stats>
+inline void SegmentTree<T, Stats>::Update(size_t index, T&& newValue)
+{
+    assert(index < count);
 
-    while (index != ptr)
+    typename Stats::Timer timer{ stats, StatsOperation::Update };
+
+    Replace(index, std::move(newValue));
+}
+
+template <typename T, typename Stats>
+template <typename... Args>
+inline void SegmentTree<T, Stats>::Emplace(size_t index, Args&&... args)
+{
+    assert(index < count);
+
+    typename Stats::Timer timer{ stats, StatsOperation::Update };
+
+    Replace(index, T(std::forward<Args>(args)...));
+}
+
+template <typename T, typename Stats>
+inline void SegmentTree<T, Stats>::Add(size_t index, T delta)
+{
+    assert(index < count);
+
+    typename Stats::Timer timer{ stats, StatsOperation::Update };
+
+    InvalidatePrefixCache();
+
+    size_t i = size / 2 + index;
+    Merge(tree[i], tree[i], delta);
+    Propagate(GetParent(i), delta);
+}
+
+template <typename T, typename Stats>
+inline void SegmentTree<T, Stats>::Insert(size_t index, T value)
+{
+    typename Stats::Timer timer{ stats, StatsOperation::Insert };
+
+    InsertRun(index, std::make_move_iterator(&value), 1);
+}
+
+template <typename T, typename Stats>
+inline void SegmentTree<T, Stats>::InsertRange(size_t index, std::span<const T> values)
+{
+    assert(index <= count);
+
+    // An empty run would move the tail onto itself, which empties values such as std::string
+    if (values.empty())
     {
-        tree[mid + ptr] = tree[mid + ptr - 1];
-        --ptr;
+        return;
     }
 
-    tree[mid + index] = value;
+    typename Stats::Timer timer{ stats, StatsOperation::Insert };
+
+    InsertRun(index, values.begin(), values.size());
+}
+
+template <typename T, typename Stats>
+inline void SegmentTree<T, Stats>::PushBack(T value)
+{
+    typename Stats::Timer timer{ stats, StatsOperation::PushBack };
+
+    InvalidatePrefixCache();
+
+    if (count == capacity)
+    {
+        size_t newSize = count == size / 2 ? size * 2 : size;
+        Resize(newSize, GetGrownCapacity(newSize, count + 1));
+    }
+
+    size_t i = size / 2 + count;
+
+    std::construct_at(tree + i, std::move(value));
     ++count;
 
-    size_t i = mid - 1;
-    while (i > 0)
+    // The ancestors whose range starts at the new leaf were not stored, they equal their left child
+    while (i > 1 && (i & 1) == 0)
     {
-        tree[i] = combineFcn(tree[GetLeft(i)], tree[GetRight(i)]);
-        --i;
+        i = GetParent(i);
+        std::construct_at(tree + i, tree[GetLeft(i)]);
     }
+
+    UpdateAncestors(i);
+}
+
+template <typename T, typename Stats>
+inline void SegmentTree<T, Stats>::Erase(size_t index)
+{
+    EraseRange(index, index + 1);
 }
 
-template <typename T>
-inline void SegmentTree<T>::PushBack(T value)
+template <typename T, typename Stats>
+inline void SegmentTree<T, Stats>::EraseRange(size_t left, size_t right)
 {
-    if (count == size / 2)
+    assert(left <= right && right <= count);
+
+    if (left == right)
     {
-        T* old = tree;
-        tree = new T[size * 2];
-        tree[0] = old[0];
+        return;
+    }
 
-        memcpy(tree + size, old + size / 2, size / 2 * sizeof(T));
+    typename Stats::Timer timer{ stats, StatsOperation::Erase };
 
-        for (size_t i = 0; i < size / 2; ++i)
-        {
-            tree[size + size / 2 + i] = old[0];
-        }
+    InvalidatePrefixCache();
 
-        delete[] old;
+    size_t mid = size / 2;
+    size_t removed = right - left;
 
-        size *= 2;
+    // Shift the tail once and destroy the vacated leaves
+    std::move(tree + mid + right, tree + mid + count, tree + mid + left);
+    std::destroy(tree + mid + count - removed, tree + mid + count);
 
-        size_t mid = size / 2;
-        tree[mid + count] = value;
-        ++count;
+    stats.OnCopy((count - right) * sizeof(T));
 
-        size_t i = mid - 1;
-        while (i > 0)
-        {
-            tree[i] = combineFcn(tree[GetLeft(i)], tree[GetRight(i)]);
-            --i;
-        }
+    DestroyStoredNodes(count - removed);
+    count -= removed;
 
-        return;
+    // The ancestors of the last leaf lost their right part even when nothing after left remains
+    Rebuild(std::min(left, count - 1), count);
+
+    ShrinkIfSparse();
+}
+
+template <typename T, typename Stats>
+inline void SegmentTree<T, Stats>::PopBack()
+{
+    assert(count > 0);
+
+    typename Stats::Timer timer{ stats, StatsOperation::PopBack };
+
+    InvalidatePrefixCache();
+
+    std::destroy_at(tree + size / 2 + count - 1);
+    DestroyStoredNodes(count - 1);
+    --count;
+
+    // The ancestors of the new last leaf lost their right part, nothing is left to rebuild once empty
+    Rebuild(count - 1, count);
+
+    ShrinkIfSparse();
+}
+
+// Grows the tree array once so that capacity elements fit without further reallocation
+// Erasing down to a quarter of the leaf slots releases it again
+template <typename T, typename Stats>
+inline void SegmentTree<T, Stats>::Reserve(size_t capacity)
+{
+    if (capacity > this->capacity)
+    {
+        Resize(std::max(size, compute_size(capacity)), capacity);
     }
+}
 
-    Update(count, value);
-    ++count;
+// Releases the leaf slots beyond count and the levels beyond the smallest power of two that holds every element
+template <typename T, typename Stats>
+inline void SegmentTree<T, Stats>::ShrinkToFit()
+{
+    if (compute_size(count) < size || count < capacity)
+    {
+        Resize(compute_size(count), count);
+    }
 }
 
-template <typename T>
-inline size_t SegmentTree<T>::GetCount() const
+// Makes prefix and suffix queries O(1) between modifications, for monoids with an inverse (e.g. sum, xor)
+// The cache is rebuilt in O(n) by the first prefix or suffix query after a modification.
+// Prefix queries then write to the cache, so they must not run concurrently.
+template <typename T, typename Stats>
+inline void SegmentTree<T, Stats>::EnablePrefixCache(Inverse* inverseFcn)
+{
+    delete prefixCache;
+    prefixCache = new PrefixCache{ inverseFcn, {}, false };
+}
+
+template <typename T, typename Stats>
+inline void SegmentTree<T, Stats>::DisablePrefixCache()
+{
+    delete prefixCache;
+    prefixCache = nullptr;
+}
+
+template <typename T, typename Stats>
+inline void SegmentTree<T, Stats>::SetInverse(Inverse* inverseFcn)
+{
+    this->inverseFcn = inverseFcn;
+}
+
+template <typename T, typename Stats>
+inline void SegmentTree<T, Stats>::EnablePrefetch()
+{
+    prefetch = true;
+}
+
+template <typename T, typename Stats>
+inline void SegmentTree<T, Stats>::DisablePrefetch()
+{
+    prefetch = false;
+}
+
+template <typename T, typename Stats>
+inline size_t SegmentTree<T, Stats>::GetCount() const
 {
     return count;
 }
 
-template <typename T>
-inline const T* SegmentTree<T>::GetTree() const
+template <typename T, typename Stats>
+inline size_t SegmentTree<T, Stats>::GetCapacity() const
+{
+    return capacity;
+}
+
+template <typename T, typename Stats>
+inline const T* SegmentTree<T, Stats>::GetTree() const
 {
     return tree;
 }
 
-template <typename T>
-inline size_t SegmentTree<T>::GetTreeSize() const
+template <typename T, typename Stats>
+inline size_t SegmentTree<T, Stats>::GetTreeSize() const
 {
     return size;
 }
 
-template <typename T>
-inline T SegmentTree<T>::GetNoneValue() const
+template <typename T, typename Stats>
+inline size_t SegmentTree<T, Stats>::GetAllocatedBytes() const
+{
+    return (size / 2 + capacity) * sizeof(T);
+}
+
+template <typename T, typename Stats>
+inline T SegmentTree<T, Stats>::GetNoneValue() const
 {
     return tree[0];
 }
 
-template <typename T>
-inline size_t SegmentTree<T>::GetLeft(size_t i) const
+template <typename T, typename Stats>
+inline const MemoryOptions& SegmentTree<T, Stats>::GetMemoryOptions() const
+{
+    return memory;
+}
+
+template <typename T, typename Stats>
+inline SegmentTreeStats SegmentTree<T, Stats>::GetStats() const
+    requires Stats::enabled
+{
+    return stats.GetSnapshot();
+}
+
+template <typename T, typename Stats>
+inline void SegmentTree<T, Stats>::ResetStats()
+    requires Stats::enabled
+{
+    stats.Reset();
+}
+
+template <typename T, typename Stats>
+inline size_t SegmentTree<T, Stats>::GetLeft(size_t i) const
 {
     return 2 * i;
 }
 
-template <typename T>
-inline size_t SegmentTree<T>::GetRight(size_t i) const
+template <typename T, typename Stats>
+inline size_t SegmentTree<T, Stats>::GetRight(size_t i) const
 {
     return 2 * i + 1;
 }
 
-template <typename T>
-inline size_t SegmentTree<T>::GetParent(size_t i) const
+template <typename T, typename Stats>
+inline size_t SegmentTree<T, Stats>::GetParent(size_t i) const
 {
     return i / 2;
 }
 
-template <typename T>
-inline T SegmentTree<T>::operator[](size_t index) const
+// Uninitialized storage for n nodes, backed as requested by the memory options
+// Every node is constructed directly from its final value, nothing is default constructed and then overwritten.
+// The array starts on a cache line, so sibling pairs and the top levels occupy as few lines as possible
+template <typename T, typename Stats>
+inline T* SegmentTree<T, Stats>::AllocateTree(size_t n) const
+{
+    return static_cast<T*>(allocate_memory(n * sizeof(T), std::max(alignof(T), cacheLineSize), memory));
+}
+
+// Destroys the stored nodes of p, a tree array laid out for size, capacity and count, and releases the storage
+template <typename T, typename Stats>
+inline void SegmentTree<T, Stats>::FreeTree(T* p, size_t size, size_t capacity, size_t count) const noexcept
+{
+    if (p != nullptr)
+    {
+        ForEachStoredRun(size, count, [&](size_t begin, size_t end) { std::destroy(p + begin, p + end); });
+        free_memory(p, (size / 2 + capacity) * sizeof(T), std::max(alignof(T), cacheLineSize), memory);
+    }
+}
+
+// Calls f(begin, end) for every run of stored nodes: noneValue, the prefix of each internal level
+// whose ranges start before count, and the leaves.
+// The stored nodes of a level end right after the ancestor of the last leaf.
+template <typename T, typename Stats>
+template <typename F>
+inline void SegmentTree<T, Stats>::ForEachStoredRun(size_t size, size_t count, F f) const
 {
+    f(size_t(0), size_t(1));
+
+    size_t end = size / 2 + count;
+    for (size_t first = size / 4; first > 0; first /= 2)
+    {
+        end = GetParent(end + 1);
+        f(first, end);
+    }
+
+    f(size / 2, size / 2 + count);
+}
+
+// Constructs the uninitialized node i from its children, childEnd is the end of the stored nodes one level below
+template <typename T, typename Stats>
+inline void SegmentTree<T, Stats>::ConstructNode(size_t i, size_t childEnd)
+{
+    stats.OnCombine();
+
+    const T& right = GetChild(GetRight(i), childEnd);
+
+    if (combineIntoFcn)
+    {
+        std::construct_at(tree + i, tree[0]);
+        combineIntoFcn(tree[i], tree[GetLeft(i)], right);
+    }
+    else
+    {
+        std::construct_at(tree + i, combineFcn(tree[GetLeft(i)], right));
+    }
+}
+
+// Constructs every stored internal node bottom up, the leaves must already be constructed
+template <typename T, typename Stats>
+inline void SegmentTree<T, Stats>::ConstructInternalNodes()
+{
+    size_t childEnd = size / 2 + count;
+
+    for (size_t first = size / 4; first > 0; first /= 2)
+    {
+        size_t end = GetParent(childEnd + 1);
+        for (size_t i = first; i < end; ++i)
+        {
+            ConstructNode(i, childEnd);
+        }
+
+        childEnd = end;
+    }
+}
+
+// Constructs the internal nodes that become stored when count grows to newCount as noneValue,
+// the caller recomputes them together with the new leaves
+template <typename T, typename Stats>
+inline void SegmentTree<T, Stats>::ConstructStoredNodes(size_t newCount)
+{
+    size_t oldEnd = size / 2 + count;
+    size_t newEnd = size / 2 + newCount;
+
+    for (size_t first = size / 4; first > 0; first /= 2)
+    {
+        oldEnd = GetParent(oldEnd + 1);
+        newEnd = GetParent(newEnd + 1);
+        std::uninitialized_fill(tree + oldEnd, tree + newEnd, tree[0]);
+    }
+}
+
+// Destroys the internal nodes that stop being stored when count shrinks to newCount
+template <typename T, typename Stats>
+inline void SegmentTree<T, Stats>::DestroyStoredNodes(size_t newCount)
+{
+    size_t oldEnd = size / 2 + count;
+    size_t newEnd = size / 2 + newCount;
+
+    for (size_t first = size / 4; first > 0; first /= 2)
+    {
+        oldEnd = GetParent(oldEnd + 1);
+        newEnd = GetParent(newEnd + 1);
+        std::destroy(tree + newEnd, tree + oldEnd);
+    }
+}
+
+// Copies count elements from data into the leaves and builds the internal nodes
+template <typename T, typename Stats>
+inline void SegmentTree<T, Stats>::Initialize(const T* data, const T& noneValue)
+{
+    tree = AllocateTree(size / 2 + capacity);
+    std::construct_at(tree, noneValue);
+
+    std::uninitialized_copy_n(data, count, tree + size / 2);
+
+    ConstructInternalNodes();
+    stats.OnRebuild();
+}
+
+// Stores the combination of left and right in out, which may alias either operand
+template <typename T, typename Stats>
+inline void SegmentTree<T, Stats>::Merge(T& out, const T& left, const T& right) const
+{
+    stats.OnCombine();
+
+    if (combineIntoFcn)
+    {
+        combineIntoFcn(out, left, right);
+    }
+    else
+    {
+        out = combineFcn(left, right);
+    }
+}
+
+template <typename T, typename Stats>
+inline void SegmentTree<T, Stats>::InvalidatePrefixCache()
+{
+    if (prefixCache)
+    {
+        prefixCache->valid = false;
+    }
+}
+
+template <typename T, typename Stats>
+inline const std::vector<T>& SegmentTree<T, Stats>::GetPrefixCache() const
+{
+    if (!prefixCache->valid)
+    {
+        std::vector<T>& values = prefixCache->values;
+        values.resize(count + 1);
+        values[0] = GetNoneValue();
+
+        const T* leaves = tree + size / 2;
+        for (size_t i = 0; i < count; ++i)
+        {
+            Merge(values[i + 1], values[i], leaves[i]);
+        }
+
+        prefixCache->valid = true;
+    }
+
+    return prefixCache->values;
+}
+
+// Same as Merge, but reports whether out changed so that walks up the tree can stop early
+// Only trivially copyable types keep the old value for the comparison, for other types (e.g. strings, vectors)
+// that copy would cost more than the walk it saves, so every node counts as changed.
+template <typename T, typename Stats>
+inline bool SegmentTree<T, Stats>::MergeChanged(T& out, const T& left, const T& right) const
+{
+    if constexpr (std::equality_comparable<T> && std::is_trivially_copyable_v<T>)
+    {
+        T old = out;
+        Merge(out, left, right);
+        return !(out == old);
+    }
+    else
+    {
+        Merge(out, left, right);
+        return true;
+    }
+}
+
+// Recomputes the internal node i from its children and reports whether it changed,
+// childEnd is the end of the stored nodes one level below
+template <typename T, typename Stats>
+inline bool SegmentTree<T, Stats>::RecomputeNode(size_t i, size_t childEnd)
+{
+    return MergeChanged(tree[i], tree[GetLeft(i)], GetChild(GetRight(i), childEnd));
+}
+
+// Child i, or noneValue when it lies at or past childEnd, the end of the stored nodes of its level
+// Selecting the operand instead of branching keeps the walks along the last leaf free of mispredictions.
+template <typename T, typename Stats>
+inline const T& SegmentTree<T, Stats>::GetChild(size_t i, size_t childEnd) const
+{
+    return tree[i < childEnd ? i : 0];
+}
+
+// Recomputes the ancestors of the stored node i, stopping at the first one that does not change
+template <typename T, typename Stats>
+inline void SegmentTree<T, Stats>::UpdateAncestors(size_t i)
+{
+    // End of the stored nodes on the level of i, one past the ancestor of the last leaf
+    size_t height = std::bit_width(size / 2) - std::bit_width(i);
+    size_t childEnd = ((size / 2 + count - 1) >> height) + 1;
+
+    while (i > 1)
+    {
+        size_t parentIndex = GetParent(i);
+        if (!RecomputeNode(parentIndex, childEnd))
+        {
+            break;
+        }
+
+        i = parentIndex;
+        childEnd = GetParent(childEnd + 1);
+    }
+}
+
+// Combines delta into node i and its ancestors, one node per level
+template <typename T, typename Stats>
+inline void SegmentTree<T, Stats>::Propagate(size_t i, const T& delta)
+{
+    if (prefetch)
+    {
+        PrefetchPath(i);
+    }
+
+    for (; i > 0; i = GetParent(i))
+    {
+        if (!MergeChanged(tree[i], tree[i], delta))
+        {
+            break;
+        }
+    }
+}
+
+// Siblings share a cache line, so the ancestors alone cover everything the update walk touches
+template <typename T, typename Stats>
+inline void SegmentTree<T, Stats>::PrefetchPath(size_t i) const
+{
+    for (; i >= hotTopNodes; i = GetParent(i))
+    {
+        prefetch_line(tree + i, true);
+    }
+}
+
+// Writes a new value to the element at index, through the inverse when one is declared
+template <typename T, typename Stats>
+template <typename U>
+inline void SegmentTree<T, Stats>::Replace(size_t index, U&& value)
+{
+    if (inverseFcn)
+    {
+        InvalidatePrefixCache();
+
+        size_t i = size / 2 + index;
+        T delta = inverseFcn(value, tree[i]);
+
+        tree[i] = std::forward<U>(value);
+        Propagate(GetParent(i), delta);
+    }
+    else
+    {
+        Assign(index, std::forward<U>(value));
+    }
+}
+
+// Writes a leaf and recomputes its ancestors
+template <typename T, typename Stats>
+template <typename U>
+inline void SegmentTree<T, Stats>::Assign(size_t index, U&& value)
+{
+    InvalidatePrefixCache();
+
+    size_t i = size / 2 + index;
+
+    if (prefetch)
+    {
+        PrefetchPath(i);
+    }
+
+    tree[i] = std::forward<U>(value);
+
+    UpdateAncestors(i);
+}
+
+// Inserts the run of inserted values read from first before index
+// Values read through a move iterator are moved into the leaves
+template <typename T, typename Stats>
+template <typename It>
+inline void SegmentTree<T, Stats>::InsertRun(size_t index, It first, size_t inserted)
+{
+    assert(index <= count);
+
+    InvalidatePrefixCache();
+
+    size_t newCount = count + inserted;
+
+    if (newCount > capacity)
+    {
+        // Grow once, placing the new run while the old leaves are moved over
+        T* old = tree;
+        size_t oldSize = size;
+        size_t oldCapacity = capacity;
+
+        size = std::max(size, compute_size(newCount));
+        capacity = GetGrownCapacity(size, newCount);
+        tree = AllocateTree(size / 2 + capacity);
+
+        size_t mid = size / 2;
+        size_t oldMid = oldSize / 2;
+        std::uninitialized_copy_n(first, inserted, tree + mid + index);
+        std::construct_at(tree, std::move(old[0]));
+        std::uninitialized_move_n(old + oldMid, index, tree + mid);
+        std::uninitialized_move_n(old + oldMid + index, count - index, tree + mid + index + inserted);
+
+        FreeTree(old, oldSize, oldCapacity, count);
+
+        stats.OnReallocate();
+        stats.OnCopy(count * sizeof(T));
+
+        count = newCount;
+        ConstructInternalNodes();
+        stats.OnRebuild();
+        return;
+    }
+
+    size_t mid = size / 2;
+    size_t tail = count - index;
+
+    // Shift the tail once, the part that lands past count goes to unconstructed leaf slots
+    if (inserted <= tail)
+    {
+        std::uninitialized_move_n(tree + mid + count - inserted, inserted, tree + mid + count);
+        std::move_backward(tree + mid + index, tree + mid + count - inserted, tree + mid + count);
+        std::copy_n(first, inserted, tree + mid + index);
+    }
+    else
+    {
+        std::uninitialized_move_n(tree + mid + index, tail, tree + mid + index + inserted);
+        std::copy_n(first, tail, tree + mid + index);
+        std::uninitialized_copy_n(first + tail, inserted - tail, tree + mid + count);
+    }
+
+    stats.OnCopy(tail * sizeof(T));
+
+    // Then only the nodes above [index, newCount) are affected
+    ConstructStoredNodes(newCount);
+    count = newCount;
+    Rebuild(index, count);
+}
+
+// Leaf capacity after growing to newCount elements in a tree array of newSize,
+// doubling the current capacity at least and never past the leaf slots of newSize
+template <typename T, typename Stats>
+inline size_t SegmentTree<T, Stats>::GetGrownCapacity(size_t newSize, size_t newCount) const
+{
+    return std::min(newSize / 2, std::max(newCount, capacity * 2));
+}
+
+// Reallocates the tree array with newSize slots and newCapacity leaves
+// Keeping the size only changes the leaf slots, so the stored nodes are moved over,
+// otherwise every internal node is rebuilt.
+template <typename T, typename Stats>
+inline void SegmentTree<T, Stats>::Resize(size_t newSize, size_t newCapacity)
+{
+    assert(newCapacity >= count && newCapacity <= newSize / 2);
+
+    T* old = tree;
+    size_t oldSize = size;
+    size_t oldCapacity = capacity;
+
+    tree = AllocateTree(newSize / 2 + newCapacity);
+    size = newSize;
+    capacity = newCapacity;
+
+    // The old array is released right after, so its nodes are moved rather than copied
+    if (size == oldSize)
+    {
+        ForEachStoredRun(size, count, [&](size_t begin, size_t end) {
+            std::uninitialized_move(old + begin, old + end, tree + begin);
+        });
+
+        FreeTree(old, oldSize, oldCapacity, count);
+
+        stats.OnReallocate();
+        stats.OnCopy(count * sizeof(T));
+        return;
+    }
+
+    std::construct_at(tree, std::move(old[0]));
+    std::uninitialized_move_n(old + oldSize / 2, count, tree + size / 2);
+
+    FreeTree(old, oldSize, oldCapacity, count);
+
+    stats.OnReallocate();
+    stats.OnCopy(count * sizeof(T));
+
+    ConstructInternalNodes();
+    stats.OnRebuild();
+}
+
+// Recomputes the internal nodes covering the leaves [begin, end)
+template <typename T, typename Stats>
+inline void SegmentTree<T, Stats>::Rebuild(size_t begin, size_t end)
+{
+    if (begin >= end)
+    {
+        return;
+    }
+
+    size_t first = GetParent(size / 2 + begin);
+    size_t last = GetParent(size / 2 + end - 1);
+    size_t childEnd = size / 2 + count;
+
+    while (first > 0)
+    {
+        for (size_t i = first; i <= last; ++i)
+        {
+            RecomputeNode(i, childEnd);
+        }
+
+        first = GetParent(first);
+        last = GetParent(last);
+        childEnd = GetParent(childEnd + 1);
+    }
+}
+
+// Shrinks the tree array once at most a quarter of the leaf slots (size / 2) are in use.
+// The shrunk tree keeps at least half of its leaves free,
+// so alternating erase and insert around the threshold cannot thrash.
+template <typename T, typename Stats>
+inline void SegmentTree<T, Stats>::ShrinkIfSparse()
+{
+    if (size > 2 && count <= size / 8)
+    {
+        Resize(compute_size(count * 2), count * 2);
+    }
+}
+
+template <typename T, typename Stats>
+inline T SegmentTree<T, Stats>::operator[](size_t index) const
+{
+    // Leaves past count are not constructed and may lie past the allocation
+    assert(index < count);
+
     return tree[size / 2 + index];
 }
\ No newline at end of file
@@ -0,0 +1,546 @@
+#pragma once
+
+#include "segment_tree.h"
+
+#include <algorithm>
+#include <initializer_list>
+#include <limits>
+#include <type_traits>
+
+// Segment tree beats (Ji Driver segment tree) over arithmetic values.
+// Supports range chmin/chmax/add updates together with sum, max and min queries.
+// Every operation runs in amortized O(log^2 n).
+// Queries push pending updates down the tree, so they are not const.
+template <typename T>
+class SegmentTreeBeats
+{
+    static_assert(std::is_arithmetic_v<T>, "SegmentTreeBeats requires an arithmetic type");
+
+public:
+    SegmentTreeBeats(std::span<const T> data);
+    SegmentTreeBeats(std::initializer_list<T> data);
+    ~SegmentTreeBeats() noexcept;
+
+    SegmentTreeBeats(const SegmentTreeBeats& other);
+    SegmentTreeBeats& operator=(const SegmentTreeBeats& other);
+    SegmentTreeBeats(SegmentTreeBeats&& other) noexcept;
+    SegmentTreeBeats& operator=(SegmentTreeBeats&& other) noexcept;
+
+    // a[i] = min(a[i], value) for i in [left, right)
+    void RangeChmin(size_t left, size_t right, T value);
+    // a[i] = max(a[i], value) for i in [left, right)
+    void RangeChmax(size_t left, size_t right, T value);
+    // a[i] = a[i] + value for i in [left, right)
+    void RangeAdd(size_t left, size_t right, T value);
+
+    T QuerySum(size_t left, size_t right);
+    T QueryMax(size_t left, size_t right);
+    T QueryMin(size_t left, size_t right);
+
+    size_t GetCount() const;
+
+private:
+    struct Node
+    {
+        T sum;
+
+        // Largest and strictly second largest values, count of the largest
+        T max1, max2;
+        size_t maxCount;
+
+        // Smallest and strictly second smallest values, count of the smallest
+        T min1, min2;
+        size_t minCount;
+
+        // A second largest or smallest value exists only when the node holds distinct values, i.e. min1 != max1,
+        // otherwise max2 and min2 equal the single value
+        // No in-band marker is used, every value of T is a valid element
+
+        // Pending addition for the children
+        T lazy;
+    };
+
+    // Identities of the max and min queries
+    static constexpr T lowest = std::numeric_limits<T>::lowest();
+    static constexpr T highest = std::numeric_limits<T>::max();
+
+    // Internal node array
+    // Root starts from index 1 and covers [0, count)
+    Node* nodes;
+
+    // Count of original elements in the tree
+    size_t count;
+
+    // Size of the node array
+    size_t size;
+
+    void Build(size_t i, size_t lo, size_t hi, const T* data);
+    void PushUp(size_t i);
+
+    static bool HasDistinct(const Node& node);
+    static T ShiftSum(T sum, T from, T to, size_t times);
+    void PushDown(size_t i, size_t lo, size_t hi);
+
+    void ApplyAdd(size_t i, size_t length, T value);
+    void ApplyChmin(size_t i, T value);
+    void ApplyChmax(size_t i, T value);
+
+    void Chmin(size_t i, size_t lo, size_t hi, size_t left, size_t right, T value);
+    void Chmax(size_t i, size_t lo, size_t hi, size_t left, size_t right, T value);
+    void Add(size_t i, size_t lo, size_t hi, size_t left, size_t right, T value);
+
+    T Sum(size_t i, size_t lo, size_t hi, size_t left, size_t right);
+    T Max(size_t i, size_t lo, size_t hi, size_t left, size_t right);
+    T Min(size_t i, size_t lo, size_t hi, size_t left, size_t right);
+};
+
+template <typename T>
+inline SegmentTreeBeats<T>::SegmentTreeBeats(std::span<const T> data)
+    : count{ data.size() }
+    , size{ compute_size(data.size()) }
+{
+    assert(count > 0);
+
+    nodes = new Node[size];
+    Build(1, 0, count, data.data());
+}
+
+template <typename T>
+inline SegmentTreeBeats<T>::SegmentTreeBeats(std::initializer_list<T> data)
+    : SegmentTreeBeats(std::span<const T>{ data.begin(), data.size() })
+{
+}
+
+template <typename T>
+inline SegmentTreeBeats<T>::~SegmentTreeBeats() noexcept
+{
+    delete[] nodes;
+}
+
+template <typename T>
+inline SegmentTreeBeats<T>::SegmentTreeBeats(const SegmentTreeBeats& other)
+{
+    count = other.count;
+    size = other.size;
+
+    nodes = new Node[size];
+    std::copy(other.nodes, other.nodes + size, nodes);
+}
+
+template <typename T>
+inline SegmentTreeBeats<T>& SegmentTreeBeats<T>::operator=(const SegmentTreeBeats& other)
+{
+    if (this != &other)
+    {
+        delete[] nodes;
+
+        count = other.count;
+        size = other.size;
+
+        nodes = new Node[size];
+        std::copy(other.nodes, other.nodes + size, nodes);
+    }
+
+    return *this;
+}
+
+template <typename T>
+inline SegmentTreeBeats<T>::SegmentTreeBeats(SegmentTreeBeats&& other) noexcept
+{
+    nodes = other.nodes;
+    count = other.count;
+    size = other.size;
+
+    other.nodes = nullptr;
+    other.count = 0;
+    other.size = 0;
+}
+
+template <typename T>
+inline SegmentTreeBeats<T>& SegmentTreeBeats<T>::operator=(SegmentTreeBeats&& other) noexcept
+{
+    if (this != &other)
+    {
+        delete[] nodes;
+
+        nodes = other.nodes;
+        count = other.count;
+        size = other.size;
+
+        other.nodes = nullptr;
+        other.count = 0;
+        other.size = 0;
+    }
+
+    return *this;
+}
+
+template <typename T>
+inline void SegmentTreeBeats<T>::RangeChmin(size_t left, size_t right, T value)
+{
+    assert(left < right && right <= count);
+
+    Chmin(1, 0, count, left, right, value);
+}
+
+template <typename T>
+inline void SegmentTreeBeats<T>::RangeChmax(size_t left, size_t right, T value)
+{
+    assert(left < right && right <= count);
+
+    Chmax(1, 0, count, left, right, value);
+}
+
+template <typename T>
+inline void SegmentTreeBeats<T>::RangeAdd(size_t left, size_t right, T value)
+{
+    assert(left < right && right <= count);
+
+    Add(1, 0, count, left, right, value);
+}
+
+template <typename T>
+inline T SegmentTreeBeats<T>::QuerySum(size_t left, size_t right)
+{
+    assert(left < right && right <= count);
+
+    return Sum(1, 0, count, left, right);
+}
+
+template <typename T>
+inline T SegmentTreeBeats<T>::QueryMax(size_t left, size_t right)
+{
+    assert(left < right && right <= count);
+
+    return Max(1, 0, count, left, right);
+}
+
+template <typename T>
+inline T SegmentTreeBeats<T>::QueryMin(size_t left, size_t right)
+{
+    assert(left < right && right <= count);
+
+    return Min(1, 0, count, left, right);
+}
+
+template <typename T>
+inline size_t SegmentTreeBeats<T>::GetCount() const
+{
+    return count;
+}
+
+template <typename T>
+inline void SegmentTreeBeats<T>::Build(size_t i, size_t lo, size_t hi, const T* data)
+{
+    Node& node = nodes[i];
+    node.lazy = T(0);
+
+    if (hi - lo == 1)
+    {
+        node.sum = data[lo];
+        node.max1 = data[lo];
+        node.max2 = data[lo];
+        node.maxCount = 1;
+        node.min1 = data[lo];
+        node.min2 = data[lo];
+        node.minCount = 1;
+        return;
+    }
+
+    size_t mid = (lo + hi) / 2;
+    Build(2 * i, lo, mid, data);
+    Build(2 * i + 1, mid, hi, data);
+    PushUp(i);
+}
+
+template <typename T>
+inline void SegmentTreeBeats<T>::PushUp(size_t i)
+{
+    Node& node = nodes[i];
+    const Node& l = nodes[2 * i];
+    const Node& r = nodes[2 * i + 1];
+
+    node.sum = l.sum + r.sum;
+
+    // The second values of a child only count when that child holds distinct values
+    bool lDistinct = HasDistinct(l);
+    bool rDistinct = HasDistinct(r);
+
+    if (l.max1 == r.max1)
+    {
+        node.max1 = l.max1;
+        node.max2 = lDistinct && rDistinct ? std::max(l.max2, r.max2) : (lDistinct ? l.max2 : r.max2);
+        node.maxCount = l.maxCount + r.maxCount;
+    }
+    else if (l.max1 > r.max1)
+    {
+        node.max1 = l.max1;
+        node.max2 = lDistinct ? std::max(l.max2, r.max1) : r.max1;
+        node.maxCount = l.maxCount;
+    }
+    else
+    {
+        node.max1 = r.max1;
+        node.max2 = rDistinct ? std::max(l.max1, r.max2) : l.max1;
+        node.maxCount = r.maxCount;
+    }
+
+    if (l.min1 == r.min1)
+    {
+        node.min1 = l.min1;
+        node.min2 = lDistinct && rDistinct ? std::min(l.min2, r.min2) : (lDistinct ? l.min2 : r.min2);
+        node.minCount = l.minCount + r.minCount;
+    }
+    else if (l.min1 < r.min1)
+    {
+        node.min1 = l.min1;
+        node.min2 = lDistinct ? std::min(l.min2, r.min1) : r.min1;
+        node.minCount = l.minCount;
+    }
+    else
+    {
+        node.min1 = r.min1;
+        node.min2 = rDistinct ? std::min(l.min1, r.min2) : l.min1;
+        node.minCount = r.minCount;
+    }
+}
+
+template <typename T>
+inline bool SegmentTreeBeats<T>::HasDistinct(const Node& node)
+{
+    return node.min1 != node.max1;
+}
+
+template <typename T>
+inline void SegmentTreeBeats<T>::PushDown(size_t i, size_t lo, size_t hi)
+{
+    Node& node = nodes[i];
+    size_t mid = (lo + hi) / 2;
+
+    if (node.lazy != T(0))
+    {
+        ApplyAdd(2 * i, mid - lo, node.lazy);
+        ApplyAdd(2 * i + 1, hi - mid, node.lazy);
+        node.lazy = T(0);
+    }
+
+    // Children can only exceed the parent's bounds through a pending chmin/chmax
+    for (size_t child = 2 * i; child <= 2 * i + 1; ++child)
+    {
+        if (nodes[child].max1 > node.max1)
+        {
+            ApplyChmin(child, node.max1);
+        }
+
+        if (nodes[child].min1 < node.min1)
+        {
+            ApplyChmax(child, node.min1);
+        }
+    }
+}
+
+// Sum after times elements change from one value to another, i.e. sum + (to - from) * times
+// Integers are combined in an unsigned type of at least int width, so a difference or product that overflows T
+// wraps back to the exact sum whenever that sum fits in T
+template <typename T>
+inline T SegmentTreeBeats<T>::ShiftSum(T sum, T from, T to, size_t times)
+{
+    if constexpr (std::is_integral_v<T>)
+    {
+        using U = std::common_type_t<std::make_unsigned_t<T>, unsigned>;
+        return T(U(sum) + (U(to) - U(from)) * U(times));
+    }
+    else
+    {
+        return sum + (to - from) * T(times);
+    }
+}
+
+template <typename T>
+inline void SegmentTreeBeats<T>::ApplyAdd(size_t i, size_t length, T value)
+{
+    Node& node = nodes[i];
+
+    node.sum = ShiftSum(node.sum, T(0), value, length);
+    node.max1 += value;
+    node.max2 += value;
+    node.min1 += value;
+    node.min2 += value;
+    node.lazy += value;
+}
+
+// Requires value < max1, and max2 < value when the node holds distinct values
+template <typename T>
+inline void SegmentTreeBeats<T>::ApplyChmin(size_t i, T value)
+{
+    Node& node = nodes[i];
+
+    node.sum = ShiftSum(node.sum, node.max1, value, node.maxCount);
+
+    if (!HasDistinct(node))
+    {
+        node.max2 = value;
+        node.min1 = value;
+        node.min2 = value;
+    }
+    else if (node.min2 == node.max1)
+    {
+        node.min2 = value;
+    }
+
+    node.max1 = value;
+}
+
+// Requires min1 < value, and value < min2 when the node holds distinct values
+template <typename T>
+inline void SegmentTreeBeats<T>::ApplyChmax(size_t i, T value)
+{
+    Node& node = nodes[i];
+
+    node.sum = ShiftSum(node.sum, node.min1, value, node.minCount);
+
+    if (!HasDistinct(node))
+    {
+        node.min2 = value;
+        node.max1 = value;
+        node.max2 = value;
+    }
+    else if (node.max2 == node.min1)
+    {
+        node.max2 = value;
+    }
+
+    node.min1 = value;
+}
+
+template <typename T>
+inline void SegmentTreeBeats<T>::Chmin(size_t i, size_t lo, size_t hi, size_t left, size_t right, T value)
+{
+    if (right <= lo || hi <= left || nodes[i].max1 <= value)
+    {
+        return;
+    }
+
+    // A leaf holds a single value, so recursion always ends at the leaves
+    if (left <= lo && hi <= right && (!HasDistinct(nodes[i]) || nodes[i].max2 < value))
+    {
+        ApplyChmin(i, value);
+        return;
+    }
+
+    assert(hi - lo > 1);
+
+    PushDown(i, lo, hi);
+
+    size_t mid = (lo + hi) / 2;
+    Chmin(2 * i, lo, mid, left, right, value);
+    Chmin(2 * i + 1, mid, hi, left, right, value);
+
+    PushUp(i);
+}
+
+template <typename T>
+inline void SegmentTreeBeats<T>::Chmax(size_t i, size_t lo, size_t hi, size_t left, size_t right, T value)
+{
+    if (right <= lo || hi <= left || nodes[i].min1 >= value)
+    {
+        return;
+    }
+
+    // A leaf holds a single value, so recursion always ends at the leaves
+    if (left <= lo && hi <= right && (!HasDistinct(nodes[i]) || nodes[i].min2 > value))
+    {
+        ApplyChmax(i, value);
+        return;
+    }
+
+    assert(hi - lo > 1);
+
+    PushDown(i, lo, hi);
+
+    size_t mid = (lo + hi) / 2;
+    Chmax(2 * i, lo, mid, left, right, value);
+    Chmax(2 * i + 1, mid, hi, left, right, value);
+
+    PushUp(i);
+}
+
+template <typename T>
+inline void SegmentTreeBeats<T>::Add(size_t i, size_t lo, size_t hi, size_t left, size_t right, T value)
+{
+    if (right <= lo || hi <= left)
+    {
+        return;
+    }
+
+    if (left <= lo && hi <= right)
+    {
+        ApplyAdd(i, hi - lo, value);
+        return;
+    }
+
+    PushDown(i, lo, hi);
+
+    size_t mid = (lo + hi) / 2;
+    Add(2 * i, lo, mid, left, right, value);
+    Add(2 * i + 1, mid, hi, left, right, value);
+
+    PushUp(i);
+}
+
+template <typename T>
+inline T SegmentTreeBeats<T>::Sum(size_t i, size_t lo, size_t hi, size_t left, size_t right)
+{
+    if (right <= lo || hi <= left)
+    {
+        return T(0);
+    }
+
+    if (left <= lo && hi <= right)
+    {
+        return nodes[i].sum;
+    }
+
+    PushDown(i, lo, hi);
+
+    size_t mid = (lo + hi) / 2;
+    return Sum(2 * i, lo, mid, left, right) + Sum(2 * i + 1, mid, hi, left, right);
+}
+
+template <typename T>
+inline T SegmentTreeBeats<T>::Max(size_t i, size_t lo, size_t hi, size_t left, size_t right)
+{
+    if (right <= lo || hi <= left)
+    {
+        return lowest;
+    }
+
+    if (left <= lo && hi <= right)
+    {
+        return nodes[i].max1;
+    }
+
+    PushDown(i, lo, hi);
+
+    size_t mid = (lo + hi) / 2;
+    return std::max(Max(2 * i, lo, mid, left, right), Max(2 * i + 1, mid, hi, left, right));
+}
+
+template <typename T>
+inline T SegmentTreeBeats<T>::Min(size_t i, size_t lo, size_t hi, size_t left, size_t right)
+{
+    if (right <= lo || hi <= left)
+    {
+        return highest;
+    }
+
+    if (left <= lo && hi <= right)
+    {
+        return nodes[i].min1;
+    }
+
+    PushDown(i, lo, hi);
+
+    size_t mid = (lo + hi) / 2;
+    return std::min(Min(2 * i, lo, mid, left, right), Min(2 * i + 1, mid, hi, left, right));
+}
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Page backing of a tree array
+enum class PageMode : uint8_t
+{
+    // Global operator new
+    Default,
+
+    // Anonymous mapping aligned to and advised for transparent huge pages (MADV_HUGEPAGE)
+    Transparent,
+
+    // Explicit huge pages from the hugetlbfs pool (MAP_HUGETLB), falls back to Transparent when the pool is exhausted
+    Explicit,
+};
+
+// Placement of a tree array across NUMA nodes
+enum class NumaPolicy : uint8_t
+{
+    // Pages are placed on the node of the thread that first touches them
+    Default,
+
+    // Pages are spread round robin over every memory node (MPOL_INTERLEAVE),
+    // so threads on every socket see the same average access latency
+    Interleave,
+};
+
+// Allocation options of a tree array
+// Everything other than the defaults only takes effect on Linux, other platforms use operator new.
+struct MemoryOptions
+{
+    PageMode pages = PageMode::Default;
+    NumaPolicy numa = NumaPolicy::Default;
+};
+
+constexpr size_t cacheLineSize = 64;
+constexpr size_t hugePageSize = size_t(2) << 20;
+
+// Allocates bytes of uninitialized storage as described by options
+void* allocate_memory(size_t bytes, size_t alignment, const MemoryOptions& options);
+
+// Releases storage returned by allocate_memory with the same bytes, alignment and options
+void free_memory(void* p, size_t bytes, size_t alignment, const MemoryOptions& options) noexcept;
+
+#if defined(__linux__)
+
+inline bool is_mapped(const MemoryOptions& options)
+{
+    return options.pages != PageMode::Default || options.numa != NumaPolicy::Default;
+}
+
+// Length of the mapping backing bytes, huge page backed mappings are rounded up to whole huge pages
+inline size_t get_mapped_length(size_t bytes, const MemoryOptions& options)
+{
+    size_t pageSize = options.pages == PageMode::Default ? size_t(sysconf(_SC_PAGESIZE)) : hugePageSize;
+    return (bytes + pageSize - 1) / pageSize * pageSize;
+}
+
+// Maps length bytes starting on a huge page boundary, so that the whole range is eligible for huge pages
+inline void* map_huge_aligned(size_t length)
+{
+    size_t reserved = length + hugePageSize;
+
+    void* p = mmap(nullptr, reserved, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+    {
+        return nullptr;
+    }
+
+    uintptr_t begin = uintptr_t(p);
+    uintptr_t aligned = (begin + hugePageSize - 1) & ~uintptr_t(hugePageSize - 1);
+
+    // Trim the unaligned head and the unused tail
+    if (aligned > begin)
+    {
+        munmap(p, aligned - begin);
+    }
+
+    uintptr_t end = aligned + length;
+    if (begin + reserved > end)
+    {
+        munmap(reinterpret_cast<void*>(end), begin + reserved - end);
+    }
+
+    return reinterpret_cast<void*>(aligned);
+}
+
+inline void* allocate_memory(size_t bytes, size_t alignment, const MemoryOptions& options)
+{
+    if (!is_mapped(options))
+    {
+        return alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__ ? ::operator new(bytes, std::align_val_t{ alignment })
+                                                            : ::operator new(bytes);
+    }
+
+    size_t length = get_mapped_length(bytes, options);
+    void* p = nullptr;
+
+    if (options.pages == PageMode::Explicit)
+    {
+        p = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        p = p == MAP_FAILED ? nullptr : p;
+    }
+
+    if (p == nullptr && options.pages != PageMode::Default)
+    {
+        p = map_huge_aligned(length);
+        if (p != nullptr)
+        {
+            // Only advisory, the mapping still works with base pages when THP is disabled
+            madvise(p, length, MADV_HUGEPAGE);
+        }
+    }
+    else if (p == nullptr)
+    {
+        p = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        p = p == MAP_FAILED ? nullptr : p;
+    }
+
+    if (p == nullptr)
+    {
+        throw std::bad_alloc{};
+    }
+
+    if (options.numa == NumaPolicy::Interleave)
+    {
+        // Raw syscall to avoid a libnuma dependency, the kernel restricts the mask to the nodes that have memory.
+        // Failure (e.g. a kernel without NUMA support) leaves the default first touch policy in place.
+        constexpr int interleave = 3; // MPOL_INTERLEAVE
+        unsigned long nodeMask[4] = { ~0ul, ~0ul, ~0ul, ~0ul };
+        syscall(SYS_mbind, p, length, interleave, nodeMask, sizeof(nodeMask) * 8, 0);
+    }
+
+    return p;
+}
+
+inline void free_memory(void* p, size_t bytes, size_t alignment, const MemoryOptions& options) noexcept
+{
+    if (p == nullptr)
+    {
+        return;
+    }
+
+    if (!is_mapped(options))
+    {
+        if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+        {
+            ::operator delete(p, std::align_val_t{ alignment });
+        }
+        else
+        {
+            ::operator delete(p);
+        }
+
+        return;
+    }
+
+    munmap(p, get_mapped_length(bytes, options));
+}
+
+#else
+
+inline void* allocate_memory(size_t bytes, size_t alignment, const MemoryOptions&)
+{
+    return alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__ ? ::operator new(bytes, std::align_val_t{ alignment })
+                                                        : ::operator new(bytes);
+}
+
+inline void free_memory(void* p, size_t, size_t alignment, const MemoryOptions&) noexcept
+{
+    if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+    {
+        ::operator delete(p, std::align_val_t{ alignment });
+    }
+    else
+    {
+        ::operator delete(p);
+    }
+}
+
+#endif
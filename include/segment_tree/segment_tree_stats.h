@@ -0,0 +1,268 @@
+#pragma once
+
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Operations timed by the instrumentation policies
+enum class StatsOperation
+{
+    Query,
+    Update,
+    Insert,
+    Erase,
+    PushBack,
+    PopBack,
+    Count,
+};
+
+// Log-linear latency histogram in the spirit of HdrHistogram
+// Values below 16 are exact, larger values are bucketed with 16 sub-buckets per power of two (6.25% precision).
+class LatencyHistogram
+{
+public:
+    void Record(uint64_t value);
+
+    uint64_t GetCount() const;
+    uint64_t GetMin() const;
+    uint64_t GetMax() const;
+    double GetMean() const;
+
+    // Lower bound of the bucket holding the given percentile in [0, 100]
+    uint64_t GetPercentile(double percentile) const;
+
+private:
+    static constexpr size_t subBucketBits = 4;
+    static constexpr size_t subBucketCount = size_t(1) << subBucketBits;
+    static constexpr size_t bucketCount = (64 - subBucketBits + 1) * subBucketCount;
+
+    uint64_t counts[bucketCount] = {};
+    uint64_t count = 0;
+    uint64_t min = UINT64_MAX;
+    uint64_t max = 0;
+    double sum = 0.0;
+
+    static size_t GetBucket(uint64_t value);
+    static uint64_t GetBucketLowerBound(size_t bucket);
+};
+
+// Snapshot of the counters recorded by a SegmentTree
+struct SegmentTreeStats
+{
+    uint64_t operations[size_t(StatsOperation::Count)] = {};
+
+    // Calls to the combine function
+    uint64_t combines = 0;
+
+    // Recomputations of every internal node
+    uint64_t rebuilds = 0;
+
+    // Reallocations of the tree array
+    uint64_t reallocations = 0;
+
+    // Bytes moved by reallocations, shifts and copies
+    uint64_t bytesCopied = 0;
+
+    LatencyHistogram latencies[size_t(StatsOperation::Count)];
+
+    uint64_t GetCount(StatsOperation op) const;
+    const LatencyHistogram& GetLatency(StatsOperation op) const;
+};
+
+// Default instrumentation policy, records nothing and compiles away
+struct NoStats
+{
+    static constexpr bool enabled = false;
+
+    struct Timer
+    {
+        Timer(NoStats&, StatsOperation)
+        {
+        }
+    };
+
+    void OnCombine()
+    {
+    }
+
+    void OnRebuild()
+    {
+    }
+
+    void OnReallocate()
+    {
+    }
+
+    void OnCopy(size_t)
+    {
+    }
+};
+
+// Instrumentation policy recording operation counts and latencies
+class RecordingStats
+{
+public:
+    static constexpr bool enabled = true;
+
+    // Counts an operation and records its latency in nanoseconds when it goes out of scope
+    class Timer
+    {
+    public:
+        Timer(RecordingStats& stats, StatsOperation op);
+        ~Timer() noexcept;
+
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+
+    private:
+        RecordingStats& stats;
+        StatsOperation op;
+        std::chrono::steady_clock::time_point begin;
+    };
+
+    void OnCombine();
+    void OnRebuild();
+    void OnReallocate();
+    void OnCopy(size_t bytes);
+
+    const SegmentTreeStats& GetSnapshot() const;
+    void Reset();
+
+private:
+    SegmentTreeStats stats;
+};
+
+inline void LatencyHistogram::Record(uint64_t value)
+{
+    ++counts[GetBucket(value)];
+    ++count;
+    min = value < min ? value : min;
+    max = value > max ? value : max;
+    sum += double(value);
+}
+
+inline uint64_t LatencyHistogram::GetCount() const
+{
+    return count;
+}
+
+inline uint64_t LatencyHistogram::GetMin() const
+{
+    return count > 0 ? min : 0;
+}
+
+inline uint64_t LatencyHistogram::GetMax() const
+{
+    return max;
+}
+
+inline double LatencyHistogram::GetMean() const
+{
+    return count > 0 ? sum / double(count) : 0.0;
+}
+
+inline uint64_t LatencyHistogram::GetPercentile(double percentile) const
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    uint64_t rank = uint64_t(percentile / 100.0 * double(count));
+    rank = rank < 1 ? 1 : (rank > count ? count : rank);
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < bucketCount; ++i)
+    {
+        seen += counts[i];
+        if (seen >= rank)
+        {
+            return GetBucketLowerBound(i);
+        }
+    }
+
+    return max;
+}
+
+inline size_t LatencyHistogram::GetBucket(uint64_t value)
+{
+    if (value < subBucketCount)
+    {
+        return size_t(value);
+    }
+
+    size_t exponent = size_t(std::bit_width(value)) - 1;
+    size_t sub = size_t(value >> (exponent - subBucketBits)) & (subBucketCount - 1);
+
+    return (exponent - subBucketBits + 1) * subBucketCount + sub;
+}
+
+inline uint64_t LatencyHistogram::GetBucketLowerBound(size_t bucket)
+{
+    if (bucket < subBucketCount)
+    {
+        return bucket;
+    }
+
+    size_t exponent = bucket / subBucketCount + subBucketBits - 1;
+    size_t sub = bucket % subBucketCount;
+
+    return (uint64_t(subBucketCount + sub)) << (exponent - subBucketBits);
+}
+
+inline uint64_t SegmentTreeStats::GetCount(StatsOperation op) const
+{
+    return operations[size_t(op)];
+}
+
+inline const LatencyHistogram& SegmentTreeStats::GetLatency(StatsOperation op) const
+{
+    return latencies[size_t(op)];
+}
+
+inline RecordingStats::Timer::Timer(RecordingStats& stats, StatsOperation op)
+    : stats{ stats }
+    , op{ op }
+    , begin{ std::chrono::steady_clock::now() }
+{
+    ++stats.stats.operations[size_t(op)];
+}
+
+inline RecordingStats::Timer::~Timer() noexcept
+{
+    auto elapsed = std::chrono::steady_clock::now() - begin;
+    uint64_t ns = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+
+    stats.stats.latencies[size_t(op)].Record(ns);
+}
+
+inline void RecordingStats::OnCombine()
+{
+    ++stats.combines;
+}
+
+inline void RecordingStats::OnRebuild()
+{
+    ++stats.rebuilds;
+}
+
+inline void RecordingStats::OnReallocate()
+{
+    ++stats.reallocations;
+}
+
+inline void RecordingStats::OnCopy(size_t bytes)
+{
+    stats.bytesCopied += bytes;
+}
+
+inline const SegmentTreeStats& RecordingStats::GetSnapshot() const
+{
+    return stats;
+}
+
+inline void RecordingStats::Reset()
+{
+    stats = SegmentTreeStats{};
+}
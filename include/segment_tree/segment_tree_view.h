@@ -0,0 +1,257 @@
+#pragma once
+
+#include "segment_tree.h"
+
+#include <algorithm>
+
+// Segment tree over a caller-owned leaf array.
+// Only the internal nodes are allocated, the leaves are read in place and never copied.
+// This lets the same buffer be shared read-only with other consumers.
+// The buffer must outlive the view, and Refresh() must be called after an element is modified.
+template <typename T>
+class SegmentTreeView
+{
+    typedef T Combine(T, T);
+
+public:
+    SegmentTreeView(std::span<const T> leaves, Combine* combineFcn, T noneValue);
+    ~SegmentTreeView() noexcept;
+
+    SegmentTreeView(const SegmentTreeView& other);
+    SegmentTreeView& operator=(const SegmentTreeView& other);
+    SegmentTreeView(SegmentTreeView&& other) noexcept;
+    SegmentTreeView& operator=(SegmentTreeView&& other) noexcept;
+
+    T Query(size_t left, size_t right) const;
+    void Refresh(size_t index);
+
+    T operator[](size_t index) const;
+
+    size_t GetCount() const;
+    const T* GetTree() const;
+    const T* GetLeaves() const;
+    size_t GetTreeSize() const;
+    T GetNoneValue() const;
+
+private:
+    // Internal nodes of the tree, indexed the same way as in SegmentTree
+    // Root starts from index 1
+    // noneValue is stored in the first element
+    T* tree;
+
+    // Caller-owned leaves, logically located at [size / 2, size / 2 + count)
+    const T* leaves;
+
+    // Combine function
+    Combine* combineFcn;
+
+    // Count of leaves
+    size_t count;
+
+    // Size of the equivalent SegmentTree array, only the first half is allocated
+    size_t size;
+
+    T GetNode(size_t i) const;
+    void Build();
+};
+
+template <typename T>
+inline SegmentTreeView<T>::SegmentTreeView(std::span<const T> leaves, Combine* combineFcn, T noneValue)
+    : leaves{ leaves.data() }
+    , combineFcn{ combineFcn }
+    , count{ leaves.size() }
+    , size{ compute_size(leaves.size()) }
+{
+    tree = new T[size / 2];
+    tree[0] = noneValue;
+
+    Build();
+}
+
+template <typename T>
+inline SegmentTreeView<T>::~SegmentTreeView() noexcept
+{
+    delete[] tree;
+}
+
+template <typename T>
+inline SegmentTreeView<T>::SegmentTreeView(const SegmentTreeView& other)
+{
+    leaves = other.leaves;
+    combineFcn = other.combineFcn;
+    count = other.count;
+    size = other.size;
+
+    tree = new T[size / 2];
+    std::copy(other.tree, other.tree + size / 2, tree);
+}
+
+template <typename T>
+inline SegmentTreeView<T>& SegmentTreeView<T>::operator=(const SegmentTreeView& other)
+{
+    if (this != &other)
+    {
+        delete[] tree;
+
+        leaves = other.leaves;
+        combineFcn = other.combineFcn;
+        count = other.count;
+        size = other.size;
+
+        tree = new T[size / 2];
+        std::copy(other.tree, other.tree + size / 2, tree);
+    }
+
+    return *this;
+}
+
+template <typename T>
+inline SegmentTreeView<T>::SegmentTreeView(SegmentTreeView&& other) noexcept
+{
+    tree = other.tree;
+    leaves = other.leaves;
+    combineFcn = other.combineFcn;
+    count = other.count;
+    size = other.size;
+
+    other.tree = nullptr;
+    other.leaves = nullptr;
+    other.combineFcn = nullptr;
+    other.count = 0;
+    other.size = 0;
+}
+
+template <typename T>
+inline SegmentTreeView<T>& SegmentTreeView<T>::operator=(SegmentTreeView&& other) noexcept
+{
+    if (this != &other)
+    {
+        delete[] tree;
+
+        tree = other.tree;
+        leaves = other.leaves;
+        combineFcn = other.combineFcn;
+        count = other.count;
+        size = other.size;
+
+        other.tree = nullptr;
+        other.leaves = nullptr;
+        other.combineFcn = nullptr;
+        other.count = 0;
+        other.size = 0;
+    }
+
+    return *this;
+}
+
+template <typename T>
+inline T SegmentTreeView<T>::Query(size_t left, size_t right) const
+{
+    assert(left < right && right <= count);
+
+    left += size / 2;
+    right += size / 2 - 1;
+
+    T leftValue = GetNoneValue();
+    T rightValue = GetNoneValue();
+
+    while (left <= right)
+    {
+        if (left & 1)
+        {
+            leftValue = combineFcn(leftValue, GetNode(left));
+        }
+
+        if (~right & 1)
+        {
+            rightValue = combineFcn(GetNode(right), rightValue);
+        }
+
+        left = (left + 1) / 2;
+        right = (right - 1) / 2;
+    }
+
+    return combineFcn(leftValue, rightValue);
+}
+
+template <typename T>
+inline void SegmentTreeView<T>::Refresh(size_t index)
+{
+    assert(index < count);
+
+    size_t i = (size / 2 + index) / 2;
+
+    while (i > 0)
+    {
+        tree[i] = combineFcn(GetNode(2 * i), GetNode(2 * i + 1));
+        i /= 2;
+    }
+}
+
+template <typename T>
+inline T SegmentTreeView<T>::operator[](size_t index) const
+{
+    return leaves[index];
+}
+
+template <typename T>
+inline size_t SegmentTreeView<T>::GetCount() const
+{
+    return count;
+}
+
+template <typename T>
+inline const T* SegmentTreeView<T>::GetTree() const
+{
+    return tree;
+}
+
+template <typename T>
+inline const T* SegmentTreeView<T>::GetLeaves() const
+{
+    return leaves;
+}
+
+template <typename T>
+inline size_t SegmentTreeView<T>::GetTreeSize() const
+{
+    return size;
+}
+
+template <typename T>
+inline T SegmentTreeView<T>::GetNoneValue() const
+{
+    return tree[0];
+}
+
+template <typename T>
+inline T SegmentTreeView<T>::GetNode(size_t i) const
+{
+    size_t mid = size / 2;
+    if (i < mid)
+    {
+        return tree[i];
+    }
+
+    // Leaves past the end of the buffer are padding
+    i -= mid;
+    return i < count ? leaves[i] : tree[0];
+}
+
+template <typename T>
+inline void SegmentTreeView<T>::Build()
+{
+    size_t mid = size / 2;
+
+    // The lowest internal level reads the leaves directly from the caller's buffer
+    size_t i = mid - 1;
+    for (; i >= mid / 2 && i > 0; --i)
+    {
+        tree[i] = combineFcn(GetNode(2 * i), GetNode(2 * i + 1));
+    }
+
+    for (; i > 0; --i)
+    {
+        tree[i] = combineFcn(tree[2 * i], tree[2 * i + 1]);
+    }
+}
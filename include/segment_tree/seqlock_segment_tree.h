@@ -0,0 +1,226 @@
+#pragma once
+
+#include "segment_tree.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+// Segment tree shared by one writer thread and any number of reader threads without a lock.
+// Update makes the sequence counter odd, rewrites the leaf and its ancestors, then makes the counter even again.
+// Readers walk the tree optimistically and retry when the counter was odd or moved during the walk,
+// so they never write shared memory and never hold the writer back.
+// Nodes are accessed through std::atomic_ref, a reader may combine values of different updates before it retries,
+// so T must be trivially copyable and Op must accept any mix of stored values.
+// Op is a stateless function object such as std::plus<>.
+template <typename T, typename Op>
+class SeqlockSegmentTree
+{
+    static_assert(std::is_trivially_copyable_v<T>, "SeqlockSegmentTree requires a trivially copyable T");
+
+public:
+    SeqlockSegmentTree(std::span<const T> data, T noneValue);
+    ~SeqlockSegmentTree() noexcept;
+
+    // Shared between threads by reference
+    SeqlockSegmentTree(const SeqlockSegmentTree&) = delete;
+    SeqlockSegmentTree& operator=(const SeqlockSegmentTree&) = delete;
+
+    // Combination over [left, right), any number of threads may query concurrently
+    T Query(size_t left, size_t right) const;
+
+    T operator[](size_t index) const;
+
+    // Only one thread may update at a time, it never waits for readers
+    void Update(size_t index, T newValue);
+
+    size_t GetCount() const;
+    size_t GetTreeSize() const;
+    T GetNoneValue() const;
+
+    // Number of completed updates
+    uint64_t GetVersion() const;
+
+private:
+    static constexpr size_t alignment = std::max(alignof(T), std::atomic_ref<T>::required_alignment);
+
+    // Twice the number of completed updates, odd while an update is in progress
+    std::atomic<uint64_t> sequence;
+
+    // Internal tree array, indexed the same way as in SegmentTree
+    // Root starts from index 1
+    // noneValue is stored in the first element
+    T* tree;
+
+    [[no_unique_address]] Op combineFcn;
+
+    // Count of original elements in the tree
+    size_t count;
+
+    // Size of the tree array
+    size_t size;
+
+    T Load(size_t i) const;
+    void Store(size_t i, T value);
+
+    // Runs read until it completes without an overlapping update and returns its result
+    template <typename F>
+    T ReadConsistent(F read) const;
+};
+
+template <typename T, typename Op>
+inline SeqlockSegmentTree<T, Op>::SeqlockSegmentTree(std::span<const T> data, T noneValue)
+    : sequence{ 0 }
+    , combineFcn{}
+    , count{ data.size() }
+    , size{ compute_size(data.size()) }
+{
+    tree = static_cast<T*>(::operator new(size * sizeof(T), std::align_val_t{ alignment }));
+
+    size_t mid = size / 2;
+
+    std::uninitialized_fill_n(tree, mid, noneValue);
+    std::uninitialized_copy(data.begin(), data.end(), tree + mid);
+    std::uninitialized_fill(tree + mid + count, tree + size, noneValue);
+
+    for (size_t i = mid - 1; i > 0; --i)
+    {
+        tree[i] = combineFcn(tree[2 * i], tree[2 * i + 1]);
+    }
+}
+
+template <typename T, typename Op>
+inline SeqlockSegmentTree<T, Op>::~SeqlockSegmentTree() noexcept
+{
+    // Trivially copyable values need no destruction
+    ::operator delete(tree, std::align_val_t{ alignment });
+}
+
+template <typename T, typename Op>
+inline T SeqlockSegmentTree<T, Op>::Query(size_t left, size_t right) const
+{
+    assert(left < right && right <= count);
+
+    return ReadConsistent([&]() {
+        size_t l = left + size / 2;
+        size_t r = right + size / 2 - 1;
+
+        T leftValue = tree[0];
+        T rightValue = tree[0];
+
+        while (l <= r)
+        {
+            if (l & 1)
+            {
+                leftValue = combineFcn(leftValue, Load(l));
+            }
+
+            if (~r & 1)
+            {
+                rightValue = combineFcn(Load(r), rightValue);
+            }
+
+            l = (l + 1) / 2;
+            r = (r - 1) / 2;
+        }
+
+        return combineFcn(leftValue, rightValue);
+    });
+}
+
+template <typename T, typename Op>
+inline T SeqlockSegmentTree<T, Op>::operator[](size_t index) const
+{
+    assert(index < count);
+
+    // A single node is read atomically, no retry needed
+    return Load(size / 2 + index);
+}
+
+template <typename T, typename Op>
+inline void SeqlockSegmentTree<T, Op>::Update(size_t index, T newValue)
+{
+    assert(index < count);
+
+    uint64_t version = sequence.load(std::memory_order_relaxed);
+    sequence.store(version + 1, std::memory_order_relaxed);
+
+    // Orders the odd counter before the node stores, pairs with the fence in ReadConsistent
+    std::atomic_thread_fence(std::memory_order_release);
+
+    size_t i = size / 2 + index;
+    Store(i, newValue);
+
+    // Readers access the same nodes through atomic_ref, so the children are read relaxed as well
+    while (i > 1)
+    {
+        i /= 2;
+        Store(i, combineFcn(Load(2 * i), Load(2 * i + 1)));
+    }
+
+    sequence.store(version + 2, std::memory_order_release);
+}
+
+template <typename T, typename Op>
+inline size_t SeqlockSegmentTree<T, Op>::GetCount() const
+{
+    return count;
+}
+
+template <typename T, typename Op>
+inline size_t SeqlockSegmentTree<T, Op>::GetTreeSize() const
+{
+    return size;
+}
+
+template <typename T, typename Op>
+inline T SeqlockSegmentTree<T, Op>::GetNoneValue() const
+{
+    return tree[0];
+}
+
+template <typename T, typename Op>
+inline uint64_t SeqlockSegmentTree<T, Op>::GetVersion() const
+{
+    return sequence.load(std::memory_order_acquire) / 2;
+}
+
+template <typename T, typename Op>
+inline T SeqlockSegmentTree<T, Op>::Load(size_t i) const
+{
+    return std::atomic_ref<T>{ tree[i] }.load(std::memory_order_relaxed);
+}
+
+template <typename T, typename Op>
+inline void SeqlockSegmentTree<T, Op>::Store(size_t i, T value)
+{
+    std::atomic_ref<T>{ tree[i] }.store(value, std::memory_order_relaxed);
+}
+
+template <typename T, typename Op>
+template <typename F>
+inline T SeqlockSegmentTree<T, Op>::ReadConsistent(F read) const
+{
+    while (true)
+    {
+        uint64_t begin = sequence.load(std::memory_order_acquire);
+
+        if (begin & 1)
+        {
+            continue;
+        }
+
+        T value = read();
+
+        // Orders the node loads before the second counter load, so a value from an overlapping update is seen as a change
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (sequence.load(std::memory_order_relaxed) == begin)
+        {
+            return value;
+        }
+    }
+}
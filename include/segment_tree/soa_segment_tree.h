@@ -0,0 +1,312 @@
+#pragma once
+
+#include "segment_tree.h"
+
+#include <algorithm>
+#include <tuple>
+#include <utility>
+
+template <typename T, typename... Ops>
+class SoASegmentTree;
+
+// Segment tree over tuples, with each field stored in its own contiguous array (structure of arrays).
+// Field I is combined with the I-th stateless function object in Ops, independently of the other fields.
+// This keeps the build loops field-wise and vectorizable, and lets queries read only the fields they need.
+template <typename... Fields, typename... Ops>
+class SoASegmentTree<std::tuple<Fields...>, Ops...>
+{
+    static_assert(sizeof...(Fields) == sizeof...(Ops), "One combine function object is required per field");
+
+public:
+    using Value = std::tuple<Fields...>;
+
+    template <size_t I>
+    using Field = std::tuple_element_t<I, Value>;
+
+    SoASegmentTree(std::span<const Value> data, Value noneValue);
+    ~SoASegmentTree() noexcept;
+
+    SoASegmentTree(const SoASegmentTree& other);
+    SoASegmentTree& operator=(const SoASegmentTree& other);
+    SoASegmentTree(SoASegmentTree&& other) noexcept;
+    SoASegmentTree& operator=(SoASegmentTree&& other) noexcept;
+
+    // Combination of every field over [left, right)
+    Value Query(size_t left, size_t right) const;
+
+    // Combination of the selected fields over [left, right), the other field arrays are not touched
+    template <size_t... I>
+    std::tuple<Field<I>...> QueryFields(size_t left, size_t right) const;
+
+    template <size_t I>
+    Field<I> QueryField(size_t left, size_t right) const;
+
+    void Update(size_t index, const Value& newValue);
+
+    Value operator[](size_t index) const;
+
+    size_t GetCount() const;
+    size_t GetTreeSize() const;
+
+    template <size_t I>
+    const Field<I>* GetField() const;
+
+private:
+    using Indices = std::index_sequence_for<Fields...>;
+
+    // One tree array per field, laid out the same way as in SegmentTree
+    // Root starts from index 1
+    // The field of noneValue is stored in the first element
+    std::tuple<Fields*...> arrays;
+
+    [[no_unique_address]] std::tuple<Ops...> combineFcns;
+
+    // Count of original elements in the tree
+    size_t count;
+
+    // Size of each field array
+    size_t size;
+
+    template <size_t I>
+    void InitField(std::span<const Value> data, Field<I> noneValue);
+
+    template <size_t I>
+    void BuildField();
+
+    template <size_t I>
+    void UpdateField(size_t index, Field<I> newValue);
+
+    template <size_t... I>
+    void Allocate(const SoASegmentTree& other, std::index_sequence<I...>);
+
+    template <size_t... I>
+    void Free(std::index_sequence<I...>) noexcept;
+};
+
+template <typename... Fields, typename... Ops>
+inline SoASegmentTree<std::tuple<Fields...>, Ops...>::SoASegmentTree(std::span<const Value> data, Value noneValue)
+    : count{ data.size() }
+    , size{ compute_size(data.size()) }
+{
+    [&]<size_t... I>(std::index_sequence<I...>) { (InitField<I>(data, std::get<I>(noneValue)), ...); }(Indices{});
+}
+
+template <typename... Fields, typename... Ops>
+inline SoASegmentTree<std::tuple<Fields...>, Ops...>::~SoASegmentTree() noexcept
+{
+    Free(Indices{});
+}
+
+template <typename... Fields, typename... Ops>
+inline SoASegmentTree<std::tuple<Fields...>, Ops...>::SoASegmentTree(const SoASegmentTree& other)
+{
+    count = other.count;
+    size = other.size;
+
+    Allocate(other, Indices{});
+}
+
+template <typename... Fields, typename... Ops>
+inline SoASegmentTree<std::tuple<Fields...>, Ops...>& SoASegmentTree<std::tuple<Fields...>, Ops...>::operator=(
+    const SoASegmentTree& other)
+{
+    if (this != &other)
+    {
+        Free(Indices{});
+
+        count = other.count;
+        size = other.size;
+
+        Allocate(other, Indices{});
+    }
+
+    return *this;
+}
+
+template <typename... Fields, typename... Ops>
+inline SoASegmentTree<std::tuple<Fields...>, Ops...>::SoASegmentTree(SoASegmentTree&& other) noexcept
+{
+    arrays = other.arrays;
+    count = other.count;
+    size = other.size;
+
+    other.arrays = {};
+    other.count = 0;
+    other.size = 0;
+}
+
+template <typename... Fields, typename... Ops>
+inline SoASegmentTree<std::tuple<Fields...>, Ops...>& SoASegmentTree<std::tuple<Fields...>, Ops...>::operator=(
+    SoASegmentTree&& other) noexcept
+{
+    if (this != &other)
+    {
+        Free(Indices{});
+
+        arrays = other.arrays;
+        count = other.count;
+        size = other.size;
+
+        other.arrays = {};
+        other.count = 0;
+        other.size = 0;
+    }
+
+    return *this;
+}
+
+template <typename... Fields, typename... Ops>
+inline auto SoASegmentTree<std::tuple<Fields...>, Ops...>::Query(size_t left, size_t right) const -> Value
+{
+    return [&]<size_t... I>(std::index_sequence<I...>) { return QueryFields<I...>(left, right); }(Indices{});
+}
+
+template <typename... Fields, typename... Ops>
+template <size_t... I>
+inline auto SoASegmentTree<std::tuple<Fields...>, Ops...>::QueryFields(size_t left, size_t right) const
+    -> std::tuple<Field<I>...>
+{
+    assert(left < right && right <= count);
+
+    left += size / 2;
+    right += size / 2 - 1;
+
+    std::tuple<Field<I>...> leftValue{ std::get<I>(arrays)[0]... };
+    std::tuple<Field<I>...> rightValue{ std::get<I>(arrays)[0]... };
+
+    // J indexes the selected fields in the result, I the fields of the tree
+    auto combine = [&]<size_t... J>(std::index_sequence<J...>) {
+        while (left <= right)
+        {
+            if (left & 1)
+            {
+                ((std::get<J>(leftValue) = std::get<I>(combineFcns)(std::get<J>(leftValue), std::get<I>(arrays)[left])), ...);
+            }
+
+            if (~right & 1)
+            {
+                ((std::get<J>(rightValue) = std::get<I>(combineFcns)(std::get<I>(arrays)[right], std::get<J>(rightValue))),
+                 ...);
+            }
+
+            left = (left + 1) / 2;
+            right = (right - 1) / 2;
+        }
+
+        return std::tuple<Field<I>...>{ std::get<I>(combineFcns)(std::get<J>(leftValue), std::get<J>(rightValue))... };
+    };
+
+    return combine(std::index_sequence_for<Field<I>...>{});
+}
+
+template <typename... Fields, typename... Ops>
+template <size_t I>
+inline auto SoASegmentTree<std::tuple<Fields...>, Ops...>::QueryField(size_t left, size_t right) const -> Field<I>
+{
+    return std::get<0>(QueryFields<I>(left, right));
+}
+
+template <typename... Fields, typename... Ops>
+inline void SoASegmentTree<std::tuple<Fields...>, Ops...>::Update(size_t index, const Value& newValue)
+{
+    assert(index < count);
+
+    [&]<size_t... I>(std::index_sequence<I...>) { (UpdateField<I>(index, std::get<I>(newValue)), ...); }(Indices{});
+}
+
+template <typename... Fields, typename... Ops>
+inline auto SoASegmentTree<std::tuple<Fields...>, Ops...>::operator[](size_t index) const -> Value
+{
+    return [&]<size_t... I>(std::index_sequence<I...>) {
+        return Value{ std::get<I>(arrays)[size / 2 + index]... };
+    }(Indices{});
+}
+
+template <typename... Fields, typename... Ops>
+inline size_t SoASegmentTree<std::tuple<Fields...>, Ops...>::GetCount() const
+{
+    return count;
+}
+
+template <typename... Fields, typename... Ops>
+inline size_t SoASegmentTree<std::tuple<Fields...>, Ops...>::GetTreeSize() const
+{
+    return size;
+}
+
+template <typename... Fields, typename... Ops>
+template <size_t I>
+inline auto SoASegmentTree<std::tuple<Fields...>, Ops...>::GetField() const -> const Field<I>*
+{
+    return std::get<I>(arrays);
+}
+
+template <typename... Fields, typename... Ops>
+template <size_t I>
+inline void SoASegmentTree<std::tuple<Fields...>, Ops...>::InitField(std::span<const Value> data, Field<I> noneValue)
+{
+    Field<I>* tree = new Field<I>[size];
+    std::get<I>(arrays) = tree;
+
+    tree[0] = noneValue;
+
+    size_t mid = size / 2;
+    for (size_t i = 0; i < count; ++i)
+    {
+        tree[mid + i] = std::get<I>(data[i]);
+    }
+
+    std::fill(tree + mid + count, tree + size, noneValue);
+
+    BuildField<I>();
+}
+
+// Builds one level at a time, so each loop only reads the level below and can be vectorized
+template <typename... Fields, typename... Ops>
+template <size_t I>
+inline void SoASegmentTree<std::tuple<Fields...>, Ops...>::BuildField()
+{
+    Field<I>* tree = std::get<I>(arrays);
+    auto& combineFcn = std::get<I>(combineFcns);
+
+    for (size_t begin = size / 4; begin > 0; begin /= 2)
+    {
+        for (size_t i = begin; i < 2 * begin; ++i)
+        {
+            tree[i] = combineFcn(tree[2 * i], tree[2 * i + 1]);
+        }
+    }
+}
+
+template <typename... Fields, typename... Ops>
+template <size_t I>
+inline void SoASegmentTree<std::tuple<Fields...>, Ops...>::UpdateField(size_t index, Field<I> newValue)
+{
+    Field<I>* tree = std::get<I>(arrays);
+    auto& combineFcn = std::get<I>(combineFcns);
+
+    size_t i = size / 2 + index;
+
+    tree[i] = newValue;
+
+    while (i > 1)
+    {
+        i /= 2;
+        tree[i] = combineFcn(tree[2 * i], tree[2 * i + 1]);
+    }
+}
+
+template <typename... Fields, typename... Ops>
+template <size_t... I>
+inline void SoASegmentTree<std::tuple<Fields...>, Ops...>::Allocate(const SoASegmentTree& other, std::index_sequence<I...>)
+{
+    ((std::get<I>(arrays) = new Field<I>[size]), ...);
+    (std::copy(std::get<I>(other.arrays), std::get<I>(other.arrays) + size, std::get<I>(arrays)), ...);
+}
+
+template <typename... Fields, typename... Ops>
+template <size_t... I>
+inline void SoASegmentTree<std::tuple<Fields...>, Ops...>::Free(std::index_sequence<I...>) noexcept
+{
+    (delete[] std::get<I>(arrays), ...);
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "segment_tree.h"
+
+#include <array>
+#include <functional>
+
+// Array size of a segment tree over n leaves, evaluated at compile time
+consteval size_t compute_static_size(size_t n)
+{
+    return compute_size(n);
+}
+
+// Segment tree with a compile-time element count, stored inline in a std::array.
+// No heap allocation and no function pointer, Op is a stateless function object such as std::plus<>.
+// Every operation is constexpr, so a tree can be built and queried at compile time.
+template <typename T, size_t N, typename Op>
+class StaticSegmentTree
+{
+    static_assert(N > 0, "StaticSegmentTree requires at least one element");
+
+public:
+    // Every element starts as noneValue
+    constexpr explicit StaticSegmentTree(T noneValue);
+    constexpr StaticSegmentTree(std::span<const T, N> data, T noneValue);
+
+    constexpr T Query(size_t left, size_t right) const;
+    constexpr void Update(size_t index, T newValue);
+
+    constexpr T operator[](size_t index) const;
+
+    static constexpr size_t GetCount();
+    constexpr const T* GetTree() const;
+    static constexpr size_t GetTreeSize();
+    constexpr T GetNoneValue() const;
+
+private:
+    static constexpr size_t size = compute_static_size(N);
+
+    // Internal tree array, laid out the same way as in SegmentTree
+    // Root starts from index 1
+    // noneValue is stored in the first element
+    std::array<T, size> tree{};
+
+    [[no_unique_address]] Op combineFcn{};
+};
+
+template <typename T, size_t N, typename Op>
+constexpr StaticSegmentTree<T, N, Op>::StaticSegmentTree(T noneValue)
+{
+    tree.fill(noneValue);
+}
+
+template <typename T, size_t N, typename Op>
+constexpr StaticSegmentTree<T, N, Op>::StaticSegmentTree(std::span<const T, N> data, T noneValue)
+{
+    tree[0] = noneValue;
+
+    size_t mid = size / 2;
+    size_t i = 0;
+
+    for (; i < N; ++i)
+    {
+        tree[mid + i] = data[i];
+    }
+
+    for (i += mid; i < size; ++i)
+    {
+        tree[i] = noneValue;
+    }
+
+    i = mid - 1;
+    while (i > 0)
+    {
+        tree[i] = combineFcn(tree[2 * i], tree[2 * i + 1]);
+        --i;
+    }
+}
+
+template <typename T, size_t N, typename Op>
+constexpr T StaticSegmentTree<T, N, Op>::Query(size_t left, size_t right) const
+{
+    assert(left < right && right <= N);
+
+    left += size / 2;
+    right += size / 2 - 1;
+
+    T leftValue = tree[0];
+    T rightValue = tree[0];
+
+    while (left <= right)
+    {
+        if (left & 1)
+        {
+            leftValue = combineFcn(leftValue, tree[left]);
+        }
+
+        if (~right & 1)
+        {
+            rightValue = combineFcn(tree[right], rightValue);
+        }
+
+        left = (left + 1) / 2;
+        right = (right - 1) / 2;
+    }
+
+    return combineFcn(leftValue, rightValue);
+}
+
+template <typename T, size_t N, typename Op>
+constexpr void StaticSegmentTree<T, N, Op>::Update(size_t index, T newValue)
+{
+    assert(index < N);
+
+    size_t i = size / 2 + index;
+
+    tree[i] = newValue;
+
+    while (i > 1)
+    {
+        i /= 2;
+        tree[i] = combineFcn(tree[2 * i], tree[2 * i + 1]);
+    }
+}
+
+template <typename T, size_t N, typename Op>
+constexpr T StaticSegmentTree<T, N, Op>::operator[](size_t index) const
+{
+    return tree[size / 2 + index];
+}
+
+template <typename T, size_t N, typename Op>
+constexpr size_t StaticSegmentTree<T, N, Op>::GetCount()
+{
+    return N;
+}
+
+template <typename T, size_t N, typename Op>
+constexpr const T* StaticSegmentTree<T, N, Op>::GetTree() const
+{
+    return tree.data();
+}
+
+template <typename T, size_t N, typename Op>
+constexpr size_t StaticSegmentTree<T, N, Op>::GetTreeSize()
+{
+    return size;
+}
+
+template <typename T, size_t N, typename Op>
+constexpr T StaticSegmentTree<T, N, Op>::GetNoneValue() const
+{
+    return tree[0];
+}
@@ -0,0 +1,355 @@
+#pragma once
+
+#include "segment_tree.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+
+// Fixed-shape segment tree stored in van Emde Boas order.
+// The tree of height h is split into a top tree of height h / 2 and the bottom trees hanging off it,
+// each stored contiguously and laid out the same way recursively,
+// so any root-to-leaf walk touches O(log_B n) cache lines whatever the line and cache sizes are.
+// The position of a node is derived during the walk from its ancestors, using one small table entry per depth.
+// Op is a stateless function object such as std::plus<>.
+template <typename T, typename Op>
+class VebSegmentTree
+{
+public:
+    VebSegmentTree(std::span<const T> data, T noneValue);
+    ~VebSegmentTree() noexcept;
+
+    VebSegmentTree(const VebSegmentTree& other);
+    VebSegmentTree& operator=(const VebSegmentTree& other);
+    VebSegmentTree(VebSegmentTree&& other) noexcept;
+    VebSegmentTree& operator=(VebSegmentTree&& other) noexcept;
+
+    // Combination over [left, right)
+    T Query(size_t left, size_t right) const;
+
+    void Update(size_t index, T newValue);
+
+    T operator[](size_t index) const;
+
+    size_t GetCount() const;
+    const T* GetTree() const;
+    size_t GetTreeSize() const;
+    T GetNoneValue() const;
+
+    // Position in the tree array of node i, indexed the same way as in SegmentTree
+    size_t GetPosition(size_t i) const;
+
+private:
+    // Where the nodes of one depth are found relative to their ancestor at depth top
+    // The ancestor roots a recursive subtree whose top tree comes first,
+    // followed by the bottom trees rooted at this depth, bottomSize positions each
+    struct Level
+    {
+        size_t top;
+
+        // Selects the bits of a node index below its ancestor at depth top,
+        // also the number of nodes in the top tree since both are 2^(depth - top) - 1
+        size_t mask;
+
+        size_t bottomSize;
+    };
+
+    // Internal tree array of size values in van Emde Boas order
+    // Root is stored at index 1
+    // noneValue is stored in the first element
+    T* tree;
+
+    [[no_unique_address]] Op combineFcn;
+
+    // Count of original elements in the tree
+    size_t count;
+
+    // Size of the tree array, same as in SegmentTree
+    size_t size;
+
+    // Depth of the leaves
+    size_t height;
+
+    std::array<Level, 64> levels;
+
+    // Fills levels for the subtree rooted at depth with levelCount levels
+    void SplitLevels(size_t depth, size_t levelCount);
+
+    // Position of the child at depth + 1, path holds the positions of its ancestors
+    size_t GetChildPosition(const size_t* path, size_t depth, size_t child) const;
+
+    // Walks from the root down to node at depth, storing the position of every node on the way into path
+    void Descend(size_t node, size_t depth, size_t* path) const;
+
+    void Build(std::span<const T> data, size_t node, size_t depth, size_t* path);
+};
+
+template <typename T, typename Op>
+inline VebSegmentTree<T, Op>::VebSegmentTree(std::span<const T> data, T noneValue)
+    : combineFcn{}
+    , count{ data.size() }
+    , size{ compute_size(data.size()) }
+    , height{ size_t(std::bit_width(size)) - 2 }
+    , levels{}
+{
+    SplitLevels(0, height + 1);
+
+    tree = new T[size];
+    tree[0] = noneValue;
+
+    size_t path[64];
+    path[0] = 1;
+    Build(data, 1, 0, path);
+}
+
+template <typename T, typename Op>
+inline VebSegmentTree<T, Op>::~VebSegmentTree() noexcept
+{
+    delete[] tree;
+}
+
+template <typename T, typename Op>
+inline VebSegmentTree<T, Op>::VebSegmentTree(const VebSegmentTree& other)
+{
+    count = other.count;
+    size = other.size;
+    height = other.height;
+    levels = other.levels;
+
+    tree = new T[size];
+    std::copy(other.tree, other.tree + size, tree);
+}
+
+template <typename T, typename Op>
+inline VebSegmentTree<T, Op>& VebSegmentTree<T, Op>::operator=(const VebSegmentTree& other)
+{
+    if (this != &other)
+    {
+        delete[] tree;
+
+        count = other.count;
+        size = other.size;
+        height = other.height;
+        levels = other.levels;
+
+        tree = new T[size];
+        std::copy(other.tree, other.tree + size, tree);
+    }
+
+    return *this;
+}
+
+template <typename T, typename Op>
+inline VebSegmentTree<T, Op>::VebSegmentTree(VebSegmentTree&& other) noexcept
+{
+    tree = other.tree;
+    count = other.count;
+    size = other.size;
+    height = other.height;
+    levels = other.levels;
+
+    other.tree = nullptr;
+    other.count = 0;
+    other.size = 0;
+    other.height = 0;
+}
+
+template <typename T, typename Op>
+inline VebSegmentTree<T, Op>& VebSegmentTree<T, Op>::operator=(VebSegmentTree&& other) noexcept
+{
+    if (this != &other)
+    {
+        delete[] tree;
+
+        tree = other.tree;
+        count = other.count;
+        size = other.size;
+        height = other.height;
+        levels = other.levels;
+
+        other.tree = nullptr;
+        other.count = 0;
+        other.size = 0;
+        other.height = 0;
+    }
+
+    return *this;
+}
+
+template <typename T, typename Op>
+inline T VebSegmentTree<T, Op>::Query(size_t left, size_t right) const
+{
+    assert(left < right && right <= count);
+
+    size_t first = size / 2 + left;
+    size_t last = size / 2 + right - 1;
+
+    // Both paths are computed in one loop so their dependency chains overlap
+    size_t leftPath[64];
+    size_t rightPath[64];
+    leftPath[0] = 1;
+    rightPath[0] = 1;
+
+    for (size_t d = 0; d < height; ++d)
+    {
+        size_t shift = height - d - 1;
+        leftPath[d + 1] = GetChildPosition(leftPath, d, first >> shift);
+        rightPath[d + 1] = GetChildPosition(rightPath, d, last >> shift);
+    }
+
+    if (first == last)
+    {
+        return tree[leftPath[height]];
+    }
+
+    // Below the lowest common ancestor, the left path collects the right siblings of its left children
+    // and the right path the left siblings of its right children
+    // Siblings differ in the lowest bit, so they are adjacent bottom trees
+    // Position 0 holds noneValue and is selected instead of branching on the side of the path
+    size_t split = height - std::bit_width(first ^ last);
+
+    T leftValue = tree[leftPath[height]];
+    T rightValue = tree[rightPath[height]];
+
+    for (size_t depth = height; depth > split + 1; --depth)
+    {
+        size_t shift = height - depth;
+        size_t bottomSize = levels[depth].bottomSize;
+
+        size_t leftSibling = (first >> shift) & 1 ? 0 : leftPath[depth] + bottomSize;
+        size_t rightSibling = (last >> shift) & 1 ? rightPath[depth] - bottomSize : 0;
+
+        leftValue = combineFcn(leftValue, tree[leftSibling]);
+        rightValue = combineFcn(tree[rightSibling], rightValue);
+    }
+
+    return combineFcn(leftValue, rightValue);
+}
+
+template <typename T, typename Op>
+inline void VebSegmentTree<T, Op>::Update(size_t index, T newValue)
+{
+    assert(index < count);
+
+    size_t node = size / 2 + index;
+
+    size_t path[64];
+    Descend(node, height, path);
+
+    tree[path[height]] = newValue;
+
+    for (size_t depth = height; depth > 0; --depth, node /= 2)
+    {
+        // Siblings differ in the lowest bit, so they are adjacent bottom trees
+        size_t bottomSize = levels[depth].bottomSize;
+        size_t leftChild = path[depth] - (node & 1) * bottomSize;
+
+        tree[path[depth - 1]] = combineFcn(tree[leftChild], tree[leftChild + bottomSize]);
+    }
+}
+
+template <typename T, typename Op>
+inline T VebSegmentTree<T, Op>::operator[](size_t index) const
+{
+    assert(index < count);
+
+    return tree[GetPosition(size / 2 + index)];
+}
+
+template <typename T, typename Op>
+inline size_t VebSegmentTree<T, Op>::GetCount() const
+{
+    return count;
+}
+
+template <typename T, typename Op>
+inline const T* VebSegmentTree<T, Op>::GetTree() const
+{
+    return tree;
+}
+
+template <typename T, typename Op>
+inline size_t VebSegmentTree<T, Op>::GetTreeSize() const
+{
+    return size;
+}
+
+template <typename T, typename Op>
+inline T VebSegmentTree<T, Op>::GetNoneValue() const
+{
+    return tree[0];
+}
+
+template <typename T, typename Op>
+inline size_t VebSegmentTree<T, Op>::GetPosition(size_t i) const
+{
+    assert(i > 0 && i < size);
+
+    size_t depth = std::bit_width(i) - 1;
+
+    size_t path[64];
+    Descend(i, depth, path);
+
+    return path[depth];
+}
+
+template <typename T, typename Op>
+inline void VebSegmentTree<T, Op>::SplitLevels(size_t depth, size_t levelCount)
+{
+    if (levelCount <= 1)
+    {
+        return;
+    }
+
+    size_t topCount = levelCount / 2;
+    size_t bottomCount = levelCount - topCount;
+
+    size_t topSize = (size_t(1) << topCount) - 1;
+    size_t bottomSize = (size_t(1) << bottomCount) - 1;
+
+    levels[depth + topCount] = Level{ depth, topSize, bottomSize };
+
+    SplitLevels(depth, topCount);
+    SplitLevels(depth + topCount, bottomCount);
+}
+
+template <typename T, typename Op>
+inline size_t VebSegmentTree<T, Op>::GetChildPosition(const size_t* path, size_t depth, size_t child) const
+{
+    const Level& level = levels[depth + 1];
+    return path[level.top] + level.mask + (child & level.mask) * level.bottomSize;
+}
+
+template <typename T, typename Op>
+inline void VebSegmentTree<T, Op>::Descend(size_t node, size_t depth, size_t* path) const
+{
+    path[0] = 1;
+
+    for (size_t d = 0; d < depth; ++d)
+    {
+        path[d + 1] = GetChildPosition(path, d, node >> (depth - d - 1));
+    }
+}
+
+template <typename T, typename Op>
+inline void VebSegmentTree<T, Op>::Build(std::span<const T> data, size_t node, size_t depth, size_t* path)
+{
+    size_t position = path[depth];
+
+    if (depth == height)
+    {
+        size_t index = node - size / 2;
+        tree[position] = index < data.size() ? data[index] : tree[0];
+        return;
+    }
+
+    size_t leftPosition = GetChildPosition(path, depth, 2 * node);
+    path[depth + 1] = leftPosition;
+    Build(data, 2 * node, depth + 1, path);
+
+    size_t rightPosition = GetChildPosition(path, depth, 2 * node + 1);
+    path[depth + 1] = rightPosition;
+    Build(data, 2 * node + 1, depth + 1, path);
+
+    tree[position] = combineFcn(tree[leftPosition], tree[rightPosition]);
+}
@@ -0,0 +1,100 @@
+#include "doctest.h"
+#include "segment_tree/blocked_segment_tree.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+struct Concat
+{
+    std::string operator()(const std::string& a, const std::string& b) const
+    {
+        return a + b;
+    }
+};
+
+static int Add(int a, int b)
+{
+    return a + b;
+}
+
+TEST_CASE("Blocked query")
+{
+    std::vector<int> data{ 5, 8, 4, 3, 7, 2, 1, 6, 9, 2, 5 };
+    BlockedSegmentTree<int, 4, std::plus<>> tree{ data, 0 };
+
+    // 11 elements in 3 buckets of 4
+    REQUIRE_EQ(tree.GetBucketCount(), 3);
+    REQUIRE_EQ(tree.GetTreeSize(), 8);
+    REQUIRE_EQ(tree.GetTree()[1], 52);
+
+    REQUIRE_EQ(tree.Query(2, 6), 16);
+    REQUIRE_EQ(tree.Query(0, 11), 52);
+    REQUIRE_EQ(tree.Query(1, 3), 12);
+    REQUIRE_EQ(tree.Query(3, 9), 28);
+    REQUIRE_EQ(tree.Query(10, 11), 5);
+    REQUIRE_EQ(tree[8], 9);
+}
+
+TEST_CASE("Blocked matches segment tree")
+{
+    for (size_t n : { size_t(1), size_t(31), size_t(32), size_t(33), size_t(100), size_t(257) })
+    {
+        std::vector<int> data(n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            data[i] = int(i * 7919 % 101);
+        }
+
+        BlockedSegmentTree<int, 32, std::plus<>> tree{ data, 0 };
+        SegmentTree<int> reference{ data, Add, 0 };
+
+        for (size_t i = 0; i < n; i += 5)
+        {
+            tree.Update(i, int(i % 13));
+            reference.Update(i, int(i % 13));
+        }
+
+        for (size_t left = 0; left < n; left += 3)
+        {
+            for (size_t right = left + 1; right <= n; ++right)
+            {
+                REQUIRE_EQ(tree.Query(left, right), reference.Query(left, right));
+            }
+        }
+    }
+}
+
+TEST_CASE("Blocked keeps operand order")
+{
+    std::vector<std::string> data;
+    std::string expected;
+    for (char c = 'a'; c <= 'z'; ++c)
+    {
+        data.push_back(std::string(1, c));
+        expected += c;
+    }
+
+    BlockedSegmentTree<std::string, 3, Concat> tree{ data, "" };
+
+    for (size_t left = 0; left < data.size(); ++left)
+    {
+        for (size_t right = left + 1; right <= data.size(); ++right)
+        {
+            REQUIRE_EQ(tree.Query(left, right), expected.substr(left, right - left));
+        }
+    }
+
+    tree.Update(7, "H");
+    REQUIRE_EQ(tree.Query(5, 10), "fgHij");
+
+    BlockedSegmentTree<std::string, 3, Concat> copy{ tree };
+    copy.Update(0, "A");
+
+    REQUIRE_EQ(tree.Query(0, 2), "ab");
+    REQUIRE_EQ(copy.Query(0, 2), "Ab");
+
+    BlockedSegmentTree<std::string, 3, Concat> moved{ std::move(copy) };
+    REQUIRE_EQ(moved.Query(0, 3), "Abc");
+    REQUIRE_EQ(copy.GetCount(), 0);
+}
@@ -0,0 +1,96 @@
+#include "doctest.h"
+#include "segment_tree/compact_leaf_segment_tree.h"
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+struct Widen
+{
+    uint64_t operator()(uint8_t leaf) const
+    {
+        return leaf;
+    }
+};
+
+using CountTree = CompactLeafSegmentTree<uint8_t, uint64_t, Widen, std::plus<>>;
+
+static uint64_t Sum(uint64_t a, uint64_t b)
+{
+    return a + b;
+}
+
+TEST_CASE("Compact leaf initialize")
+{
+    std::vector<uint8_t> data{ 250, 8, 4, 255, 7, 2, 1 };
+    CountTree tree{ data, 0 };
+
+    std::vector<uint64_t> wide(data.begin(), data.end());
+    SegmentTree<uint64_t> reference{ wide, Sum, 0 };
+
+    REQUIRE_EQ(tree.GetTreeSize(), reference.GetTreeSize());
+
+    // Internal nodes must match the tree over widened leaves
+    for (size_t i = 0; i < tree.GetTreeSize() / 2; ++i)
+    {
+        REQUIRE_EQ(tree.GetTree()[i], reference.GetTree()[i]);
+    }
+
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        REQUIRE_EQ(tree[i], data[i]);
+    }
+
+    // The node type holds sums that overflow the leaf type
+    REQUIRE_EQ(tree.Query(0, 7), 527);
+    REQUIRE_EQ(tree.Query(3, 5), 262);
+}
+
+TEST_CASE("Compact leaf update")
+{
+    std::vector<uint8_t> data;
+    std::vector<uint64_t> wide;
+    for (int i = 0; i < 37; ++i)
+    {
+        data.push_back(uint8_t(i * 37 % 256));
+        wide.push_back(data.back());
+    }
+
+    CountTree tree{ data, 0 };
+    SegmentTree<uint64_t> reference{ wide, Sum, 0 };
+
+    for (size_t i = 0; i < data.size(); i += 3)
+    {
+        tree.Update(i, uint8_t(255 - i));
+        reference.Update(i, 255 - i);
+    }
+
+    for (size_t left = 0; left < data.size(); ++left)
+    {
+        for (size_t right = left + 1; right <= data.size(); ++right)
+        {
+            REQUIRE_EQ(tree.Query(left, right), reference.Query(left, right));
+        }
+    }
+
+    CountTree copy{ tree };
+    copy.Update(0, 0);
+
+    REQUIRE_EQ(tree[0], 255);
+    REQUIRE_EQ(copy.Query(0, 1), 0);
+
+    CountTree moved{ std::move(copy) };
+    REQUIRE_EQ(moved.Query(0, 37), reference.Query(0, 37) - 255);
+    REQUIRE_EQ(copy.GetCount(), 0);
+}
+
+TEST_CASE("Compact leaf single element")
+{
+    std::vector<uint8_t> data{ 42 };
+    CountTree tree{ data, 0 };
+
+    REQUIRE_EQ(tree.Query(0, 1), 42);
+
+    tree.Update(0, 7);
+    REQUIRE_EQ(tree.Query(0, 1), 7);
+}
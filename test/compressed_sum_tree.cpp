@@ -0,0 +1,86 @@
+#include "doctest.h"
+#include "segment_tree/compressed_sum_tree.h"
+
+#include <vector>
+
+TEST_CASE("Compressed widths")
+{
+    std::vector<uint64_t> data(1000, 255);
+    CompressedSumTree tree{ data, 255 };
+
+    // 1000 leaves, then 500, 250, ... down to the root
+    REQUIRE_EQ(tree.GetLevelCount(), 11);
+    REQUIRE_EQ(tree.GetLevelWidth(0), 1);
+
+    // Sums of up to 2^8 leaves stay below 65536
+    for (size_t k = 1; k <= 8; ++k)
+    {
+        REQUIRE_EQ(tree.GetLevelWidth(k), 2);
+    }
+
+    REQUIRE_EQ(tree.GetLevelWidth(9), 4);
+    REQUIRE_EQ(tree.GetLevelWidth(10), 4);
+
+    REQUIRE_EQ(tree.Query(0, 1000), 255000);
+
+    // About 3 bytes per leaf, against the 16 bytes per leaf of SegmentTree<uint64_t>
+    REQUIRE_LT(tree.GetMemoryUsage(), 4 * data.size());
+}
+
+TEST_CASE("Compressed query and update")
+{
+    for (size_t n : { 1, 2, 3, 7, 64, 100, 257 })
+    {
+        std::vector<uint64_t> data(n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            data[i] = i * 37 % 1000;
+        }
+
+        CompressedSumTree tree{ data, 1000 };
+
+        uint32_t seed = 5;
+        auto next = [&]() {
+            seed = seed * 1664525u + 1013904223u;
+            return size_t(seed >> 8);
+        };
+
+        for (int step = 0; step < 200; ++step)
+        {
+            size_t index = next() % n;
+            uint64_t value = next() % 1001;
+
+            tree.Update(index, value);
+            data[index] = value;
+
+            REQUIRE_EQ(tree[index], value);
+
+            size_t a = next() % n;
+            size_t b = next() % n;
+            size_t left = a < b ? a : b;
+            size_t right = (a < b ? b : a) + 1;
+
+            uint64_t expected = 0;
+            for (size_t i = left; i < right; ++i)
+            {
+                expected += data[i];
+            }
+
+            REQUIRE_EQ(tree.Query(left, right), expected);
+        }
+    }
+}
+
+TEST_CASE("Compressed 64-bit levels")
+{
+    std::vector<uint64_t> data{ UINT32_MAX, UINT32_MAX, 1, UINT32_MAX };
+    CompressedSumTree tree{ data, UINT32_MAX };
+
+    REQUIRE_EQ(tree.GetLevelWidth(0), 4);
+    REQUIRE_EQ(tree.GetLevelWidth(1), 8);
+
+    REQUIRE_EQ(tree.Query(0, 4), 3 * uint64_t(UINT32_MAX) + 1);
+
+    tree.Update(2, 0);
+    REQUIRE_EQ(tree.Query(1, 4), 2 * uint64_t(UINT32_MAX));
+}
@@ -0,0 +1,128 @@
+#include "doctest.h"
+#include "segment_tree/half_segment_tree.h"
+
+#include <functional>
+#include <vector>
+
+using HalfSumTree = HalfSegmentTree<int, std::plus<>, std::minus<>>;
+
+static int Sum(int a, int b)
+{
+    return a + b;
+}
+
+TEST_CASE("Half query")
+{
+    std::vector<int> data{ 5, 8, 4, 3, 7, 2, 1 };
+    HalfSumTree tree{ data, 0 };
+
+    // Capacity values instead of the 2 * capacity of SegmentTree
+    REQUIRE_EQ(tree.GetCapacity(), 8);
+    REQUIRE_EQ(tree.GetTree()[0], 30);
+    REQUIRE_EQ(tree.GetTree()[1], 20);
+    REQUIRE_EQ(tree.GetTree()[2], 13);
+    REQUIRE_EQ(tree.GetTree()[3], 9);
+
+    REQUIRE_EQ(tree.Query(2, 6), 16);
+    REQUIRE_EQ(tree.Query(0, 7), 30);
+    REQUIRE_EQ(tree.PrefixQuery(0), 0);
+    REQUIRE_EQ(tree.PrefixQuery(3), 17);
+
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        REQUIRE_EQ(tree[i], data[i]);
+    }
+}
+
+TEST_CASE("Half matches segment tree")
+{
+    for (size_t n : { size_t(1), size_t(2), size_t(31), size_t(64), size_t(100) })
+    {
+        std::vector<int> data(n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            data[i] = int(i * 7919 % 101);
+        }
+
+        HalfSumTree tree{ data, 0 };
+        SegmentTree<int> reference{ data, Sum, 0 };
+
+        for (size_t i = 0; i < n; i += 3)
+        {
+            tree.Update(i, int(i % 17));
+            reference.Update(i, int(i % 17));
+        }
+
+        tree.Add(n - 1, 5);
+        reference.Update(n - 1, reference[n - 1] + 5);
+
+        for (size_t left = 0; left < n; ++left)
+        {
+            REQUIRE_EQ(tree[left], reference[left]);
+
+            for (size_t right = left + 1; right <= n; ++right)
+            {
+                REQUIRE_EQ(tree.Query(left, right), reference.Query(left, right));
+            }
+        }
+    }
+}
+
+TEST_CASE("Half push back")
+{
+    HalfSumTree tree{ std::span<const int>{}, 0 };
+    SegmentTree<int> reference{ {}, Sum, 0 };
+
+    for (int i = 0; i < 70; ++i)
+    {
+        tree.PushBack(i * 3 % 11);
+        reference.PushBack(i * 3 % 11);
+
+        REQUIRE_EQ(tree.GetCount(), reference.GetCount());
+        REQUIRE_EQ(tree.Query(0, tree.GetCount()), reference.Query(0, reference.GetCount()));
+    }
+
+    REQUIRE_EQ(tree.GetCapacity(), 128);
+
+    for (size_t left = 0; left < 70; ++left)
+    {
+        for (size_t right = left + 1; right <= 70; ++right)
+        {
+            REQUIRE_EQ(tree.Query(left, right), reference.Query(left, right));
+        }
+    }
+
+    HalfSegmentTree<unsigned, std::bit_xor<>, std::bit_xor<>> xorTree{ std::span<const unsigned>{}, 0u };
+    for (unsigned i = 0; i < 9; ++i)
+    {
+        xorTree.PushBack(1u << i);
+    }
+
+    REQUIRE_EQ(xorTree.Query(2, 5), 0b11100u);
+    REQUIRE_EQ(xorTree[8], 256u);
+}
+
+TEST_CASE("Half lower bound")
+{
+    std::vector<int> data{ 2, 0, 3, 1, 0, 4 };
+    HalfSumTree tree{ data, 0 };
+
+    // Inclusive prefixes 2, 2, 5, 6, 6, 10
+    REQUIRE_EQ(tree.LowerBound(0), 0);
+    REQUIRE_EQ(tree.LowerBound(2), 0);
+    REQUIRE_EQ(tree.LowerBound(3), 2);
+    REQUIRE_EQ(tree.LowerBound(6), 3);
+    REQUIRE_EQ(tree.LowerBound(7), 5);
+    REQUIRE_EQ(tree.LowerBound(10), 5);
+    REQUIRE_EQ(tree.LowerBound(11), 6);
+
+    HalfSumTree copy{ tree };
+    copy.Update(0, 9);
+
+    REQUIRE_EQ(tree.LowerBound(3), 2);
+    REQUIRE_EQ(copy.LowerBound(3), 0);
+
+    HalfSumTree moved{ std::move(copy) };
+    REQUIRE_EQ(moved.Query(0, 6), 17);
+    REQUIRE_EQ(copy.GetCount(), 0);
+}
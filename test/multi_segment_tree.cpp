@@ -0,0 +1,118 @@
+#include "doctest.h"
+#include "segment_tree/multi_segment_tree.h"
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+struct Max
+{
+    int operator()(int a, int b) const
+    {
+        return std::max(a, b);
+    }
+};
+
+using SumTree = MultiSegmentTree<int, 3, std::plus<>>;
+
+TEST_CASE("Multi query")
+{
+    std::vector<SumTree::Row> data{ { 5, 1, 0 }, { 8, 2, 0 }, { 4, 3, 1 }, { 3, 4, 0 }, { 7, 5, 1 }, { 2, 6, 0 }, { 1, 7, 1 } };
+
+    SumTree tree{ data, { 0, 0, 0 } };
+
+    REQUIRE_EQ(tree.GetTreeSize(), 16);
+    REQUIRE_EQ(tree.GetNode(1)[0], 30);
+    REQUIRE_EQ(tree.GetNode(1)[1], 28);
+    REQUIRE_EQ(tree.GetNode(1)[2], 3);
+
+    REQUIRE(tree.Query(1, 5) == SumTree::Row{ 22, 14, 2 });
+    REQUIRE(tree.Query(0, 7) == SumTree::Row{ 30, 28, 3 });
+    REQUIRE_EQ(tree.Query(2, 7, 1), 25);
+    REQUIRE(tree[4] == SumTree::Row{ 7, 5, 1 });
+}
+
+TEST_CASE("Multi update")
+{
+    SumTree tree{ 5, { 0, 0, 0 } };
+
+    REQUIRE(tree.Query(0, 5) == SumTree::Row{ 0, 0, 0 });
+
+    tree.Update(2, { 1, 2, 3 });
+    tree.Update(4, { 10, 20, 30 });
+    tree.Update(0, 1, 100);
+
+    REQUIRE(tree.Query(0, 5) == SumTree::Row{ 11, 122, 33 });
+    REQUIRE(tree.Query(0, 3) == SumTree::Row{ 1, 102, 3 });
+    REQUIRE_EQ(tree.Query(3, 5, 2), 30);
+    REQUIRE(tree[0] == SumTree::Row{ 0, 100, 0 });
+}
+
+TEST_CASE("Multi matches independent trees")
+{
+    constexpr size_t columns = 4;
+    constexpr size_t n = 100;
+
+    using Tree = MultiSegmentTree<int, columns, Max>;
+
+    std::vector<Tree::Row> rows(n);
+    std::vector<std::vector<int>> values(columns, std::vector<int>(n));
+
+    unsigned seed = 17;
+    auto next = [&]() {
+        seed = seed * 1103515245 + 12345;
+        return int(seed >> 16) % 1000;
+    };
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        for (size_t k = 0; k < columns; ++k)
+        {
+            rows[i][k] = values[k][i] = next();
+        }
+    }
+
+    Tree tree{ rows, { -1, -1, -1, -1 } };
+
+    for (int step = 0; step < 200; ++step)
+    {
+        size_t index = size_t(next()) % n;
+        size_t column = size_t(next()) % columns;
+        int value = next();
+
+        tree.Update(index, column, value);
+        values[column][index] = value;
+
+        size_t a = size_t(next()) % n;
+        size_t b = size_t(next()) % n;
+        size_t left = std::min(a, b);
+        size_t right = std::max(a, b) + 1;
+
+        Tree::Row result = tree.Query(left, right);
+        for (size_t k = 0; k < columns; ++k)
+        {
+            int expected = *std::max_element(values[k].begin() + left, values[k].begin() + right);
+            REQUIRE_EQ(result[k], expected);
+            REQUIRE_EQ(tree.Query(left, right, k), expected);
+        }
+    }
+}
+
+TEST_CASE("Multi copy and move")
+{
+    SumTree tree{ 3, { 0, 0, 0 } };
+    tree.Update(1, { 1, 2, 3 });
+
+    SumTree copy{ tree };
+    copy.Update(0, { 4, 4, 4 });
+
+    REQUIRE(tree.Query(0, 3) == SumTree::Row{ 1, 2, 3 });
+    REQUIRE(copy.Query(0, 3) == SumTree::Row{ 5, 6, 7 });
+
+    SumTree moved{ std::move(copy) };
+    REQUIRE(moved.Query(0, 3) == SumTree::Row{ 5, 6, 7 });
+    REQUIRE_EQ(copy.GetCount(), 0);
+
+    tree = moved;
+    REQUIRE(tree.Query(0, 3) == SumTree::Row{ 5, 6, 7 });
+}
@@ -0,0 +1,175 @@
+#include "doctest.h"
+#include "segment_tree/segment_tree_beats.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+TEST_CASE("Beats basic")
+{
+    SegmentTreeBeats<int> tree{ 5, 8, 4, 3, 7, 2, 1, 6 };
+
+    REQUIRE_EQ(tree.QuerySum(0, 8), 36);
+    REQUIRE_EQ(tree.QueryMax(0, 8), 8);
+    REQUIRE_EQ(tree.QueryMin(0, 8), 1);
+
+    // { 5, 5, 4, 3, 5, 2, 1, 5 }
+    tree.RangeChmin(0, 8, 5);
+    REQUIRE_EQ(tree.QuerySum(0, 8), 30);
+    REQUIRE_EQ(tree.QueryMax(0, 8), 5);
+
+    // { 5, 5, 4, 3, 5, 3, 3, 5 }
+    tree.RangeChmax(4, 8, 3);
+    REQUIRE_EQ(tree.QuerySum(4, 8), 16);
+    REQUIRE_EQ(tree.QueryMin(0, 8), 3);
+
+    // { 5, 7, 6, 5, 5, 3, 3, 5 }
+    tree.RangeAdd(1, 4, 2);
+    REQUIRE_EQ(tree.QuerySum(0, 8), 39);
+    REQUIRE_EQ(tree.QueryMax(0, 4), 7);
+    REQUIRE_EQ(tree.QueryMin(1, 3), 6);
+}
+
+// Applies random chmin/chmax/add updates and sum/max/min queries to the tree and a naive array, next() draws the operands
+// Sums are done in T on both sides, so narrow types wrap the same way
+template <typename T, typename Next>
+static void CheckDifferential(std::mt19937& rng, size_t n, Next next, bool withAdd = true)
+{
+    std::uniform_int_distribution<size_t> indexDist{ 0, n - 1 };
+    std::uniform_int_distribution<int> opDist{ 0, 5 };
+
+    std::vector<T> naive(n);
+    for (T& v : naive)
+    {
+        v = next();
+    }
+
+    SegmentTreeBeats<T> tree{ naive };
+    SegmentTreeBeats<T> copy{ tree };
+
+    T initialSum = T(0);
+    for (T v : naive)
+    {
+        initialSum = T(initialSum + v);
+    }
+
+    for (int step = 0; step < 2000; ++step)
+    {
+        size_t l = indexDist(rng);
+        size_t r = indexDist(rng);
+        if (l > r)
+        {
+            std::swap(l, r);
+        }
+        ++r;
+
+        T x = next();
+        int op = opDist(rng);
+
+        if (op == 2 && !withAdd)
+        {
+            continue;
+        }
+
+        switch (op)
+        {
+        case 0:
+            tree.RangeChmin(l, r, x);
+            for (size_t i = l; i < r; ++i)
+            {
+                naive[i] = std::min(naive[i], x);
+            }
+            break;
+        case 1:
+            tree.RangeChmax(l, r, x);
+            for (size_t i = l; i < r; ++i)
+            {
+                naive[i] = std::max(naive[i], x);
+            }
+            break;
+        case 2:
+            tree.RangeAdd(l, r, x);
+            for (size_t i = l; i < r; ++i)
+            {
+                naive[i] = T(naive[i] + x);
+            }
+            break;
+        case 3:
+        {
+            T sum = T(0);
+            for (size_t i = l; i < r; ++i)
+            {
+                sum = T(sum + naive[i]);
+            }
+            REQUIRE_EQ(tree.QuerySum(l, r), sum);
+            break;
+        }
+        case 4:
+            REQUIRE_EQ(tree.QueryMax(l, r), *std::max_element(naive.begin() + l, naive.begin() + r));
+            break;
+        case 5:
+            REQUIRE_EQ(tree.QueryMin(l, r), *std::min_element(naive.begin() + l, naive.begin() + r));
+            break;
+        }
+    }
+
+    // The copy must be unaffected by updates to the original
+    REQUIRE_EQ(copy.QuerySum(0, n), initialSum);
+}
+
+TEST_CASE("Beats differential")
+{
+    std::mt19937 rng{ 1234 };
+    std::uniform_int_distribution<int64_t> valueDist{ -50, 50 };
+
+    for (size_t n : { 1, 2, 3, 17, 64, 100 })
+    {
+        CheckDifferential<int64_t>(rng, n, [&]() { return valueDist(rng); });
+    }
+}
+
+TEST_CASE("Beats unsigned")
+{
+    std::mt19937 rng{ 5678 };
+
+    // Mostly small values so zero, the lowest unsigned value, is hit often
+    std::uniform_int_distribution<unsigned> valueDist{ 0, 4 };
+
+    for (size_t n : { 1, 2, 3, 17, 64, 100 })
+    {
+        CheckDifferential<unsigned>(rng, n, [&]() { return valueDist(rng); });
+    }
+}
+
+TEST_CASE("Beats extreme values")
+{
+    std::mt19937 rng{ 9012 };
+
+    // Includes the lowest and highest representable values as elements and as chmin/chmax operands
+    // Adds are left out, an add that wraps around does not preserve the order of the values
+    std::vector<int8_t> pool{ INT8_MIN, INT8_MIN + 1, -1, 0, 1, INT8_MAX - 1, INT8_MAX };
+    std::uniform_int_distribution<size_t> poolDist{ 0, pool.size() - 1 };
+
+    for (size_t n : { 1, 2, 3, 17, 64, 100 })
+    {
+        CheckDifferential<int8_t>(rng, n, [&]() { return pool[poolDist(rng)]; }, false);
+    }
+
+    // The sums fit in int, while the differences and products on the way there do not
+    constexpr int highest = std::numeric_limits<int>::max();
+    SegmentTreeBeats<int> tree{ highest - 5, 3 };
+
+    tree.RangeChmin(0, 2, -10);
+    REQUIRE_EQ(tree.QuerySum(0, 2), -20);
+    REQUIRE_EQ(tree.QueryMax(0, 2), -10);
+
+    tree.RangeChmax(1, 2, highest - 1);
+    REQUIRE_EQ(tree.QuerySum(0, 2), highest - 11);
+    REQUIRE_EQ(tree.QueryMin(0, 2), -10);
+    REQUIRE_EQ(tree.QueryMax(0, 2), highest - 1);
+
+    tree.RangeAdd(0, 2, -(highest / 2));
+    REQUIRE_EQ(tree.QuerySum(0, 2), highest - 11 - 2 * (highest / 2));
+}
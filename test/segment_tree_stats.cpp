@@ -0,0 +1,119 @@
+#include "doctest.h"
+#include "segment_tree/segment_tree.h"
+
+static int Sum(int a, int b)
+{
+    return a + b;
+}
+
+#if !defined(_MSC_VER)
+// Disabled instrumentation must not grow the tree, so the recording tree is larger by exactly its counters
+static_assert(sizeof(SegmentTree<int, RecordingStats>) == sizeof(SegmentTree<int, NoStats>) + sizeof(RecordingStats));
+#endif
+
+TEST_CASE("Stats counters")
+{
+    int data[8] = { 5, 8, 4, 3, 7, 2, 1, 6 };
+    SegmentTree<int, RecordingStats> tree{ data, Sum, 0 };
+
+    SegmentTreeStats stats = tree.GetStats();
+
+    REQUIRE_EQ(stats.rebuilds, 1);
+    REQUIRE_EQ(stats.combines, 7);
+
+    tree.ResetStats();
+
+    tree.Update(4, 10);
+    REQUIRE_EQ(tree.Query(2, 6), 19);
+    REQUIRE_EQ(tree.Query(0, 8), 39);
+
+    stats = tree.GetStats();
+
+    REQUIRE_EQ(stats.GetCount(StatsOperation::Update), 1);
+    REQUIRE_EQ(stats.GetCount(StatsOperation::Query), 2);
+    REQUIRE_EQ(stats.GetLatency(StatsOperation::Query).GetCount(), 2);
+    REQUIRE_EQ(stats.rebuilds, 0);
+    REQUIRE_EQ(stats.reallocations, 0);
+
+    // Three ancestors for the update, plus the query steps
+    REQUIRE_GT(stats.combines, 3);
+
+    tree.PushBack(1);
+
+    stats = tree.GetStats();
+
+    REQUIRE_EQ(stats.GetCount(StatsOperation::PushBack), 1);
+    REQUIRE_EQ(stats.GetCount(StatsOperation::Update), 1);
+    REQUIRE_EQ(stats.reallocations, 1);
+    REQUIRE_EQ(stats.rebuilds, 1);
+    REQUIRE_EQ(stats.bytesCopied, 8 * sizeof(int));
+
+    tree.Insert(0, 3);
+    tree.Erase(0);
+    tree.PopBack();
+
+    stats = tree.GetStats();
+
+    REQUIRE_EQ(stats.GetCount(StatsOperation::Insert), 1);
+    REQUIRE_EQ(stats.GetCount(StatsOperation::Erase), 1);
+    REQUIRE_EQ(stats.GetCount(StatsOperation::PopBack), 1);
+    REQUIRE_EQ(stats.bytesCopied, 8 * sizeof(int) + 9 * sizeof(int) + 9 * sizeof(int));
+}
+
+static int Max(int a, int b)
+{
+    return a > b ? a : b;
+}
+
+TEST_CASE("Stats early stop")
+{
+    int data[8] = { 5, 8, 4, 3, 7, 2, 1, 6 };
+    SegmentTree<int, RecordingStats> tree{ data, Max, 0 };
+
+    tree.ResetStats();
+
+    // The sibling 8 keeps the parent unchanged, so only one ancestor is recomputed
+    tree.Update(0, 6);
+    REQUIRE_EQ(tree.GetStats().combines, 1);
+
+    tree.ResetStats();
+
+    // Raising a leaf to at most its parent changes nothing above it
+    tree.Add(2, 4);
+    REQUIRE_EQ(tree.GetStats().combines, 2);
+
+    tree.ResetStats();
+
+    // A new maximum travels all the way to the root
+    tree.Add(5, 9);
+    REQUIRE_EQ(tree.GetStats().combines, 4);
+    REQUIRE_EQ(tree.Query(0, 8), 9);
+    REQUIRE_EQ(tree.Query(0, 4), 8);
+}
+
+TEST_CASE("Latency histogram")
+{
+    LatencyHistogram histogram;
+
+    REQUIRE_EQ(histogram.GetPercentile(50), 0);
+
+    for (uint64_t i = 1; i <= 1000; ++i)
+    {
+        histogram.Record(i);
+    }
+
+    REQUIRE_EQ(histogram.GetCount(), 1000);
+    REQUIRE_EQ(histogram.GetMin(), 1);
+    REQUIRE_EQ(histogram.GetMax(), 1000);
+    REQUIRE_EQ(histogram.GetMean(), doctest::Approx(500.5));
+    REQUIRE_EQ(histogram.GetPercentile(1), 10);
+
+    // Buckets keep 1/16 relative precision
+    uint64_t median = histogram.GetPercentile(50);
+    REQUIRE_LE(median, 500);
+    REQUIRE_GE(median, 500 - 500 / 16);
+
+    uint64_t p99 = histogram.GetPercentile(99);
+    REQUIRE_LE(p99, 990);
+    REQUIRE_GE(p99, 990 - 990 / 16);
+}
@@ -0,0 +1,97 @@
+#include "doctest.h"
+#include "segment_tree/segment_tree_view.h"
+
+#include <vector>
+
+static int Sum(int a, int b)
+{
+    return a + b;
+}
+
+TEST_CASE("View initialize")
+{
+    const int data[7] = { 5, 8, 4, 3, 7, 2, 1 };
+    SegmentTreeView<int> view{ data, Sum, 0 };
+    SegmentTree<int> tree{ std::span<int>{ const_cast<int*>(data), 7 }, Sum, 0 };
+
+    REQUIRE_EQ(view.GetTreeSize(), tree.GetTreeSize());
+    REQUIRE_EQ(view.GetLeaves(), data);
+
+    // Internal nodes must match the owning tree
+    for (size_t i = 0; i < view.GetTreeSize() / 2; ++i)
+    {
+        REQUIRE_EQ(view.GetTree()[i], tree.GetTree()[i]);
+    }
+
+    for (int i = 0; i < 7; ++i)
+    {
+        REQUIRE_EQ(view[i], data[i]);
+    }
+}
+
+TEST_CASE("View query")
+{
+    std::vector<int> data;
+    for (int i = 0; i < 37; ++i)
+    {
+        data.push_back(i * 7 % 11);
+    }
+
+    SegmentTreeView<int> view{ data, Sum, 0 };
+
+    for (size_t l = 0; l < data.size(); ++l)
+    {
+        int expected = 0;
+        for (size_t r = l + 1; r <= data.size(); ++r)
+        {
+            expected += data[r - 1];
+            REQUIRE_EQ(view.Query(l, r), expected);
+        }
+    }
+}
+
+TEST_CASE("View refresh")
+{
+    int data[8] = { 5, 8, 4, 3, 7, 2, 1, 6 };
+    SegmentTreeView<int> view{ std::span<const int>{ data }, Sum, 0 };
+
+    REQUIRE_EQ(view.Query(0, 8), 36);
+
+    data[4] = 10;
+    view.Refresh(4);
+
+    REQUIRE_EQ(view.GetTree()[1], 39);
+    REQUIRE_EQ(view.GetTree()[3], 19);
+    REQUIRE_EQ(view.GetTree()[6], 12);
+    REQUIRE_EQ(view.Query(2, 6), 19);
+}
+
+TEST_CASE("View single element")
+{
+    int data[1] = { 42 };
+    SegmentTreeView<int> view{ std::span<const int>{ data }, Sum, 0 };
+
+    REQUIRE_EQ(view.Query(0, 1), 42);
+
+    data[0] = 7;
+    view.Refresh(0);
+
+    REQUIRE_EQ(view.Query(0, 1), 7);
+}
+
+TEST_CASE("View copy and move")
+{
+    int data[5] = { 1, 2, 3, 4, 5 };
+    SegmentTreeView<int> view1{ std::span<const int>{ data }, Sum, 0 };
+    SegmentTreeView<int> view2{ view1 };
+
+    REQUIRE_NE(view1.GetTree(), view2.GetTree());
+    REQUIRE_EQ(view1.GetLeaves(), view2.GetLeaves());
+    REQUIRE_EQ(view2.Query(1, 4), 9);
+
+    SegmentTreeView<int> view3{ std::move(view1) };
+
+    REQUIRE_EQ(view1.GetTree(), nullptr);
+    REQUIRE_EQ(view1.GetCount(), 0);
+    REQUIRE_EQ(view3.Query(0, 5), 15);
+}
@@ -0,0 +1,139 @@
+#include "doctest.h"
+#include "segment_tree/seqlock_segment_tree.h"
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <functional>
+#include <thread>
+#include <vector>
+
+using SeqlockSumTree = SeqlockSegmentTree<int, std::plus<>>;
+
+static int Sum(int a, int b)
+{
+    return a + b;
+}
+
+// Smallest and largest value of a range
+struct Bounds
+{
+    int min;
+    int max;
+};
+
+struct CombineBounds
+{
+    Bounds operator()(Bounds a, Bounds b) const
+    {
+        return Bounds{ std::min(a.min, b.min), std::max(a.max, b.max) };
+    }
+};
+
+TEST_CASE("Seqlock query")
+{
+    std::vector<int> data{ 5, 8, 4, 3, 7, 2, 1 };
+    SeqlockSumTree tree{ data, 0 };
+
+    REQUIRE_EQ(tree.GetCount(), 7);
+    REQUIRE_EQ(tree.GetTreeSize(), 16);
+    REQUIRE_EQ(tree.GetNoneValue(), 0);
+    REQUIRE_EQ(tree.GetVersion(), 0);
+
+    REQUIRE_EQ(tree.Query(2, 6), 16);
+    REQUIRE_EQ(tree.Query(0, 7), 30);
+
+    tree.Update(3, 10);
+    tree.Update(6, 0);
+
+    REQUIRE_EQ(tree.GetVersion(), 2);
+    REQUIRE_EQ(tree.Query(0, 7), 36);
+    REQUIRE_EQ(tree[3], 10);
+}
+
+TEST_CASE("Seqlock matches segment tree")
+{
+    for (size_t n : { size_t(1), size_t(2), size_t(31), size_t(64), size_t(100) })
+    {
+        std::vector<int> data(n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            data[i] = int(i * 7919 % 101);
+        }
+
+        SeqlockSumTree tree{ data, 0 };
+        SegmentTree<int> reference{ data, Sum, 0 };
+
+        for (size_t i = 0; i < n; i += 3)
+        {
+            tree.Update(i, int(i % 17));
+            reference.Update(i, int(i % 17));
+        }
+
+        for (size_t left = 0; left < n; ++left)
+        {
+            for (size_t right = left + 1; right <= n; ++right)
+            {
+                REQUIRE_EQ(tree.Query(left, right), reference.Query(left, right));
+            }
+
+            REQUIRE_EQ(tree[left], reference[left]);
+        }
+    }
+}
+
+TEST_CASE("Seqlock readers see whole updates")
+{
+    constexpr size_t n = 100;
+    constexpr int generations = 200;
+
+    std::vector<Bounds> data(n, Bounds{ 0, 0 });
+    SeqlockSegmentTree<Bounds, CombineBounds> tree{ data, Bounds{ INT_MAX, INT_MIN } };
+
+    // The writer raises the elements one at a time to the next generation,
+    // so any state between two updates holds at most two adjacent generations
+    std::atomic<bool> done{ false };
+    std::atomic<size_t> torn{ 0 };
+    std::atomic<size_t> reads{ 0 };
+
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 3; ++t)
+    {
+        readers.emplace_back([&]() {
+            while (!done.load(std::memory_order_relaxed))
+            {
+                Bounds bounds = tree.Query(0, n);
+                if (bounds.max - bounds.min > 1)
+                {
+                    torn.fetch_add(1, std::memory_order_relaxed);
+                }
+                reads.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    // Lets the readers start before the updates
+    while (reads.load(std::memory_order_relaxed) < readers.size())
+    {
+        std::this_thread::yield();
+    }
+
+    for (int g = 1; g <= generations; ++g)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            tree.Update(i, Bounds{ g, g });
+        }
+    }
+
+    done.store(true, std::memory_order_relaxed);
+    for (std::thread& reader : readers)
+    {
+        reader.join();
+    }
+
+    REQUIRE_EQ(torn.load(), 0);
+    REQUIRE_EQ(tree.GetVersion(), n * generations);
+    REQUIRE_EQ(tree.Query(0, n).min, generations);
+    REQUIRE_EQ(tree.Query(0, n).max, generations);
+}
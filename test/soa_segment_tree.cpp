@@ -0,0 +1,97 @@
+#include "doctest.h"
+#include "segment_tree/soa_segment_tree.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+struct Min
+{
+    int operator()(int a, int b) const
+    {
+        return std::min(a, b);
+    }
+};
+
+struct Max
+{
+    int operator()(int a, int b) const
+    {
+        return std::max(a, b);
+    }
+};
+
+// { sum, min, max, count }
+using Aggregate = std::tuple<int64_t, int, int, uint32_t>;
+using AggregateTree = SoASegmentTree<Aggregate, std::plus<>, Min, Max, std::plus<>>;
+
+static const Aggregate none{ 0, std::numeric_limits<int>::max(), std::numeric_limits<int>::min(), 0 };
+
+static Aggregate Make(int value)
+{
+    return Aggregate{ value, value, value, 1 };
+}
+
+TEST_CASE("SoA query")
+{
+    std::vector<Aggregate> data;
+    for (int v : { 5, 8, 4, 3, 7, 2, 1 })
+    {
+        data.push_back(Make(v));
+    }
+
+    AggregateTree tree{ data, none };
+
+    REQUIRE_EQ(tree.GetTreeSize(), 16);
+    REQUIRE_EQ(tree.GetField<0>()[1], 30);
+    REQUIRE_EQ(tree.GetField<1>()[1], 1);
+    REQUIRE_EQ(tree.GetField<2>()[1], 8);
+    REQUIRE_EQ(tree.GetField<3>()[1], 7);
+
+    REQUIRE(tree.Query(1, 5) == Aggregate{ 22, 3, 8, 4 });
+    REQUIRE(tree.QueryFields<2, 0>(2, 7) == std::tuple<int, int64_t>{ 7, 17 });
+    REQUIRE_EQ(tree.QueryField<1>(0, 3), 4);
+    REQUIRE(tree[3] == Make(3));
+}
+
+TEST_CASE("SoA update")
+{
+    std::vector<Aggregate> data;
+    for (int i = 0; i < 37; ++i)
+    {
+        data.push_back(Make(i * 11 % 23));
+    }
+
+    AggregateTree tree{ data, none };
+
+    for (int step = 0; step < 37; ++step)
+    {
+        size_t index = step * 5 % 37;
+        data[index] = Make(step - 10);
+        tree.Update(index, data[index]);
+
+        size_t left = step % 13;
+        size_t right = 37 - step % 7;
+
+        Aggregate expected = none;
+        for (size_t i = left; i < right; ++i)
+        {
+            std::get<0>(expected) += std::get<0>(data[i]);
+            std::get<1>(expected) = std::min(std::get<1>(expected), std::get<1>(data[i]));
+            std::get<2>(expected) = std::max(std::get<2>(expected), std::get<2>(data[i]));
+            std::get<3>(expected) += std::get<3>(data[i]);
+        }
+
+        REQUIRE(tree.Query(left, right) == expected);
+    }
+
+    AggregateTree copy{ tree };
+    REQUIRE(copy.Query(0, 37) == tree.Query(0, 37));
+    REQUIRE_NE(copy.GetField<0>(), tree.GetField<0>());
+
+    AggregateTree moved{ std::move(copy) };
+    REQUIRE_EQ(copy.GetField<0>(), nullptr);
+    REQUIRE(moved.Query(0, 37) == tree.Query(0, 37));
+}
@@ -0,0 +1,67 @@
+#include "doctest.h"
+#include "segment_tree/static_segment_tree.h"
+
+#include <algorithm>
+
+struct Max
+{
+    constexpr int operator()(int a, int b) const
+    {
+        return std::max(a, b);
+    }
+};
+
+static_assert(compute_static_size(8) == 16);
+static_assert(compute_static_size(7) == 16);
+static_assert(compute_static_size(1) == 2);
+
+#if !defined(_MSC_VER)
+// No allocation, no function pointer and no count: just the node array
+static_assert(sizeof(StaticSegmentTree<int, 8, std::plus<>>) == 16 * sizeof(int));
+#endif
+
+constexpr int data[8] = { 5, 8, 4, 3, 7, 2, 1, 6 };
+
+constexpr StaticSegmentTree<int, 8, std::plus<>> sumTree{ data, 0 };
+static_assert(sumTree.GetTree()[1] == 36);
+static_assert(sumTree.Query(2, 6) == 16);
+static_assert(sumTree.Query(0, 7) == 30);
+
+constexpr int UpdatedSum()
+{
+    StaticSegmentTree<int, 8, std::plus<>> tree{ data, 0 };
+    tree.Update(4, 10);
+    return tree.Query(0, 8);
+}
+
+static_assert(UpdatedSum() == 39);
+
+TEST_CASE("Static initialize")
+{
+    constexpr int data7[7] = { 5, 8, 4, 3, 7, 2, 1 };
+    StaticSegmentTree<int, 7, std::plus<>> tree{ data7, 0 };
+
+    REQUIRE_EQ(tree.GetTreeSize(), 16);
+    REQUIRE_EQ(tree.GetCount(), 7);
+
+    const int expected[16] = { 0, 30, 20, 10, 13, 7, 9, 1, 5, 8, 4, 3, 7, 2, 1, 0 };
+    for (int i = 0; i < 16; ++i)
+    {
+        REQUIRE_EQ(tree.GetTree()[i], expected[i]);
+    }
+}
+
+TEST_CASE("Static query and update")
+{
+    StaticSegmentTree<int, 5, Max> tree{ -1 };
+
+    REQUIRE_EQ(tree.Query(0, 5), -1);
+
+    tree.Update(3, 9);
+    tree.Update(0, 4);
+
+    REQUIRE_EQ(tree[3], 9);
+    REQUIRE_EQ(tree.Query(0, 3), 4);
+    REQUIRE_EQ(tree.Query(0, 5), 9);
+    REQUIRE_EQ(tree.Query(4, 5), -1);
+}
@@ -2,6 +2,10 @@
 #include "doctest.h"
 #include "segment_tree/segment_tree.h"
 
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <string>
 #include <vector>
 
 TEST_CASE("Memory leak check")
@@ -17,6 +21,14 @@ int Combine(int a, int b)
     return a + b;
 }
 
+// Whether node i of the tree array is stored, leaves past the count and the nodes above only them are not
+static bool IsStored(const SegmentTree<int>& tree, size_t i)
+{
+    size_t mid = tree.GetTreeSize() / 2;
+    size_t height = std::bit_width(mid) - std::bit_width(i);
+    return i == 0 || (i << height) - mid < tree.GetCount();
+}
+
 /*
                  36
           20            16
@@ -85,7 +97,11 @@ TEST_CASE("Initialize 2")
     REQUIRE_EQ(p[12], 7);
     REQUIRE_EQ(p[13], 2);
     REQUIRE_EQ(p[14], 1);
-    REQUIRE_EQ(p[15], 0);
+
+    // The padded leaf is neither allocated nor written
+    REQUIRE_EQ(tree.GetCapacity(), 7);
+    REQUIRE_FALSE(IsStored(tree, 15));
+    REQUIRE_EQ(tree.GetAllocatedBytes(), 15 * sizeof(int));
 }
 
 TEST_CASE("Update")
@@ -145,6 +161,104 @@ TEST_CASE("Query")
     REQUIRE_EQ(tree.Query(2, 6), 16);
 }
 
+TEST_CASE("Query branchless")
+{
+    std::vector<int> data;
+    for (int i = 0; i < 45; ++i)
+    {
+        data.push_back(i * 13 % 17);
+    }
+
+    SegmentTree<int> tree{ data, Combine, 0 };
+
+    for (size_t left = 0; left < data.size(); ++left)
+    {
+        for (size_t right = left + 1; right <= data.size(); ++right)
+        {
+            REQUIRE_EQ(tree.QueryBranchless(left, right), tree.Query(left, right));
+        }
+    }
+}
+
+// Affine maps x -> a * x + b mod 1009, composed left to right, which is not commutative
+struct Affine
+{
+    int a, b;
+
+    bool operator==(const Affine& other) const = default;
+};
+
+Affine Compose(Affine f, Affine g)
+{
+    return Affine{ f.a * g.a % 1009, (f.b * g.a + g.b) % 1009 };
+}
+
+TEST_CASE("Prefix and suffix query")
+{
+    for (int n : { 1, 2, 5, 8, 13 })
+    {
+        std::vector<Affine> data;
+        for (int i = 0; i < n; ++i)
+        {
+            data.push_back(Affine{ i + 2, i * 3 + 1 });
+        }
+
+        SegmentTree<Affine> tree{ data, Compose, Affine{ 1, 0 } };
+
+        REQUIRE_EQ(tree.PrefixQuery(0), Affine{ 1, 0 });
+        REQUIRE_EQ(tree.SuffixQuery(n), Affine{ 1, 0 });
+
+        for (int i = 1; i <= n; ++i)
+        {
+            REQUIRE_EQ(tree.PrefixQuery(i), tree.Query(0, i));
+            REQUIRE_EQ(tree.SuffixQuery(n - i), tree.Query(n - i, n));
+        }
+    }
+}
+
+int Subtract(int a, int b)
+{
+    return a - b;
+}
+
+TEST_CASE("Prefix cache")
+{
+    int data[7] = { 5, 8, 4, 3, 7, 2, 1 };
+    SegmentTree<int> tree{ data, Combine, 0 };
+
+    tree.EnablePrefixCache(Subtract);
+
+    REQUIRE_EQ(tree.PrefixQuery(0), 0);
+    REQUIRE_EQ(tree.PrefixQuery(3), 17);
+    REQUIRE_EQ(tree.PrefixQuery(7), 30);
+    REQUIRE_EQ(tree.SuffixQuery(5), 3);
+
+    // Modifications invalidate the cache
+    tree.Update(1, 10);
+    REQUIRE_EQ(tree.PrefixQuery(3), 19);
+
+    tree.PushBack(6);
+    REQUIRE_EQ(tree.PrefixQuery(8), 38);
+
+    tree.Insert(0, 100);
+    REQUIRE_EQ(tree.SuffixQuery(1), 38);
+    REQUIRE_EQ(tree.PrefixQuery(1), 100);
+
+    tree.EraseRange(0, 2);
+    REQUIRE_EQ(tree.PrefixQuery(2), 14);
+    REQUIRE_EQ(tree.SuffixQuery(0), 33);
+
+    SegmentTree<int> copy{ tree };
+    tree.PopBack();
+
+    REQUIRE_EQ(tree.SuffixQuery(0), 27);
+    REQUIRE_EQ(copy.SuffixQuery(0), 33);
+
+    tree.DisablePrefixCache();
+
+    REQUIRE_EQ(tree.PrefixQuery(6), 27);
+}
+
 TEST_CASE("Insert 1")
 {
     int data[8] = { 5, 8, 4, 3, 7, 2, 1, 6 };
@@ -161,15 +275,11 @@ TEST_CASE("Insert 1")
     REQUIRE_EQ(p[4], 26);
     REQUIRE_EQ(p[5], 13);
     REQUIRE_EQ(p[6], 6);
-    REQUIRE_EQ(p[7], 0);
     REQUIRE_EQ(p[8], 13);
     REQUIRE_EQ(p[9], 13);
     REQUIRE_EQ(p[10], 10);
     REQUIRE_EQ(p[11], 3);
     REQUIRE_EQ(p[12], 6);
-    REQUIRE_EQ(p[13], 0);
-    REQUIRE_EQ(p[14], 0);
-    REQUIRE_EQ(p[15], 0);
     REQUIRE_EQ(p[16], 5);
     REQUIRE_EQ(p[17], 8);
     REQUIRE_EQ(p[18], 4);
@@ -179,13 +289,14 @@ TEST_CASE("Insert 1")
     REQUIRE_EQ(p[22], 2);
     REQUIRE_EQ(p[23], 1);
     REQUIRE_EQ(p[24], 6);
-    REQUIRE_EQ(p[25], 0);
-    REQUIRE_EQ(p[26], 0);
-    REQUIRE_EQ(p[27], 0);
-    REQUIRE_EQ(p[28], 0);
-    REQUIRE_EQ(p[29], 0);
-    REQUIRE_EQ(p[30], 0);
-    REQUIRE_EQ(p[31], 0);
+
+    // Growth doubles the capacity, the nodes that only cover padding are not stored
+    REQUIRE_EQ(tree.GetCapacity(), 16);
+
+    for (size_t i : { 7, 13, 14, 15, 25, 31 })
+    {
+        REQUIRE_FALSE(IsStored(tree, i));
+    }
 }
 
 TEST_CASE("Insert 2")
@@ -197,9 +308,127 @@ TEST_CASE("Insert 2")
     tree1.Insert(8, 123);
     tree2.PushBack(123);
 
-    for (int i = 0; i < tree1.GetTreeSize(); ++i)
+    REQUIRE_EQ(tree1.GetCapacity(), tree2.GetCapacity());
+
+    for (size_t i = 0; i < tree1.GetTreeSize(); ++i)
     {
-        REQUIRE_EQ(tree1.GetTree()[i], tree2.GetTree()[i]);
+        if (IsStored(tree1, i))
+        {
+            REQUIRE_EQ(tree1.GetTree()[i], tree2.GetTree()[i]);
+        }
+    }
+}
+
+TEST_CASE("Insert range")
+{
+    int data[5] = { 5, 8, 4, 3, 7 };
+    int values[3] = { 10, 20, 30 };
+    SegmentTree<int> tree{ data, Combine, 0 };
+
+    // Reserved, so the run fits without growing and shifts the tail in place
+    tree.Reserve(8);
+    const int* before = tree.GetTree();
+    tree.InsertRange(1, values);
+
+    REQUIRE_EQ(tree.GetTree(), before);
+
+    REQUIRE_EQ(tree.GetCount(), 8);
+    REQUIRE_EQ(tree.GetTreeSize(), 16);
+
+    int expected1[8] = { 5, 10, 20, 30, 8, 4, 3, 7 };
+    for (int i = 0; i < 8; ++i)
+    {
+        REQUIRE_EQ(tree[i], expected1[i]);
+    }
+    REQUIRE_EQ(tree.Query(0, 8), 87);
+    REQUIRE_EQ(tree.Query(3, 6), 42);
+
+    // Grows once to fit the whole run
+    int more[9] = { 1, 1, 1, 1, 1, 1, 1, 1, 1 };
+    tree.InsertRange(8, more);
+
+    REQUIRE_EQ(tree.GetCount(), 17);
+    REQUIRE_EQ(tree.GetTreeSize(), 64);
+    REQUIRE_EQ(tree.Query(0, 17), 96);
+    REQUIRE_EQ(tree.Query(7, 10), 9);
+    REQUIRE_EQ(tree.GetCapacity(), 17);
+
+    tree.InsertRange(0, std::span<const int>{});
+
+    REQUIRE_EQ(tree.GetCount(), 17);
+}
+
+TEST_CASE("Insert range matches insert")
+{
+    int data[6] = { 5, 8, 4, 3, 7, 2 };
+    int values[4] = { 9, 6, 3, 1 };
+    SegmentTree<int> tree1{ data, Combine, 0 };
+    SegmentTree<int> tree2{ data, Combine, 0 };
+
+    tree1.InsertRange(2, values);
+    for (int i = 3; i >= 0; --i)
+    {
+        tree2.Insert(2, values[i]);
+    }
+
+    REQUIRE_EQ(tree1.GetTreeSize(), tree2.GetTreeSize());
+    for (size_t i = 0; i < tree1.GetTreeSize(); ++i)
+    {
+        if (IsStored(tree1, i))
+        {
+            REQUIRE_EQ(tree1.GetTree()[i], tree2.GetTree()[i]);
+        }
+    }
+}
+
+TEST_CASE("Reserve")
+{
+    int data[3] = { 5, 8, 4 };
+    SegmentTree<int> tree{ data, Combine, 0 };
+
+    REQUIRE_EQ(tree.GetCapacity(), 3);
+
+    tree.Reserve(100);
+
+    REQUIRE_EQ(tree.GetCapacity(), 100);
+    REQUIRE_EQ(tree.GetTreeSize(), 256);
+    REQUIRE_EQ(tree.Query(0, 3), 17);
+
+    const int* p = tree.GetTree();
+    for (int i = 0; i < 97; ++i)
+    {
+        tree.PushBack(1);
+    }
+
+    // No reallocation happened while filling the reserved capacity
+    REQUIRE_EQ(tree.GetTree(), p);
+    REQUIRE_EQ(tree.GetCount(), 100);
+    REQUIRE_EQ(tree.Query(0, 100), 114);
+
+    // Reserving less than the capacity is a no-op
+    tree.Reserve(10);
+
+    REQUIRE_EQ(tree.GetTree(), p);
+}
+
+TEST_CASE("Shrink to fit")
+{
+    int data[8] = { 5, 8, 4, 3, 7, 2, 1, 6 };
+    SegmentTree<int> tree{ data, Combine, 0 };
+
+    tree.PushBack(9);
+
+    REQUIRE_EQ(tree.GetTreeSize(), 32);
+
+    tree.PopBack();
+    tree.ShrinkToFit();
+
+    REQUIRE_EQ(tree.GetTreeSize(), 16);
+
+    SegmentTree<int> expected{ data, Combine, 0 };
+    for (size_t i = 0; i < tree.GetTreeSize(); ++i)
+    {
+        REQUIRE_EQ(tree.GetTree()[i], expected.GetTree()[i]);
     }
 }
 
@@ -338,4 +567,701 @@ TEST_CASE("Move assign")
     REQUIRE_EQ(p[13], 2);
     REQUIRE_EQ(p[14], 1);
     REQUIRE_EQ(p[15], 6);
-}
\ No newline at end of file
+}
+
+TEST_CASE("Erase")
+{
+    int data[8] = { 5, 8, 4, 3, 7, 2, 1, 6 };
+    SegmentTree<int> tree{ data, Combine, 0 };
+
+    tree.Erase(3);
+
+    REQUIRE_EQ(tree.GetCount(), 7);
+    REQUIRE_EQ(tree.GetTreeSize(), 16);
+
+    const int* p = tree.GetTree();
+
+    REQUIRE_EQ(p[0], 0);
+    REQUIRE_EQ(p[1], 33);
+    REQUIRE_EQ(p[2], 24);
+    REQUIRE_EQ(p[3], 9);
+    REQUIRE_EQ(p[4], 13);
+    REQUIRE_EQ(p[5], 11);
+    REQUIRE_EQ(p[6], 3);
+    REQUIRE_EQ(p[7], 6);
+    REQUIRE_EQ(p[8], 5);
+    REQUIRE_EQ(p[9], 8);
+    REQUIRE_EQ(p[10], 4);
+    REQUIRE_EQ(p[11], 7);
+    REQUIRE_EQ(p[12], 2);
+    REQUIRE_EQ(p[13], 1);
+    REQUIRE_EQ(p[14], 6);
+
+    // The vacated leaf is destroyed, its slot stays allocated
+    REQUIRE_EQ(tree.GetCapacity(), 8);
+    REQUIRE_FALSE(IsStored(tree, 15));
+}
+
+TEST_CASE("Erase range")
+{
+    int data[8] = { 5, 8, 4, 3, 7, 2, 1, 6 };
+    SegmentTree<int> tree{ data, Combine, 0 };
+
+    tree.EraseRange(1, 5);
+
+    REQUIRE_EQ(tree.GetCount(), 4);
+    REQUIRE_EQ(tree[0], 5);
+    REQUIRE_EQ(tree[1], 2);
+    REQUIRE_EQ(tree[2], 1);
+    REQUIRE_EQ(tree[3], 6);
+    REQUIRE_EQ(tree.Query(0, 4), 14);
+    REQUIRE_EQ(tree.Query(1, 3), 3);
+
+    tree.EraseRange(2, 2);
+
+    REQUIRE_EQ(tree.GetCount(), 4);
+    REQUIRE_EQ(tree.Query(0, 4), 14);
+}
+
+TEST_CASE("Pop back")
+{
+    int data[8] = { 5, 8, 4, 3, 7, 2, 1, 6 };
+    SegmentTree<int> tree{ data, Combine, 0 };
+
+    tree.PopBack();
+
+    REQUIRE_EQ(tree.GetCount(), 7);
+    REQUIRE_EQ(tree.GetCapacity(), 8);
+    REQUIRE_EQ(tree.GetTree()[7], 1);
+    REQUIRE_EQ(tree.Query(0, 7), 30);
+
+    tree.PushBack(10);
+
+    REQUIRE_EQ(tree.Query(0, 8), 40);
+}
+
+TEST_CASE("Shrink on erase")
+{
+    std::vector<int> data(64, 1);
+    SegmentTree<int> tree{ data, Combine, 0 };
+
+    REQUIRE_EQ(tree.GetTreeSize(), 128);
+
+    // Still more than a quarter of the leaves in use
+    tree.EraseRange(0, 47);
+    REQUIRE_EQ(tree.GetTreeSize(), 128);
+
+    tree.PopBack();
+    REQUIRE_EQ(tree.GetCount(), 16);
+    REQUIRE_EQ(tree.GetTreeSize(), 64);
+    REQUIRE_EQ(tree.Query(0, 16), 16);
+
+    while (tree.GetCount() > 0)
+    {
+        tree.PopBack();
+    }
+
+    REQUIRE_EQ(tree.GetTreeSize(), 2);
+
+    tree.PushBack(3);
+    tree.PushBack(4);
+
+    REQUIRE_EQ(tree.Query(0, 2), 7);
+}
+
+TEST_CASE("Insert and erase random")
+{
+    std::vector<int> naive = { 1, 2, 3 };
+    SegmentTree<int> tree{ naive, Combine, 0 };
+
+    uint32_t seed = 7;
+    auto next = [&seed]() {
+        seed = seed * 1664525 + 1013904223;
+        return seed >> 8;
+    };
+
+    for (int step = 0; step < 3000; ++step)
+    {
+        switch (next() % 5)
+        {
+        case 0:
+        {
+            size_t index = next() % (naive.size() + 1);
+            int value = next() % 100;
+            naive.insert(naive.begin() + index, value);
+            tree.Insert(index, value);
+            break;
+        }
+        case 1:
+        {
+            int value = next() % 100;
+            naive.push_back(value);
+            tree.PushBack(value);
+            break;
+        }
+        case 2:
+            if (!naive.empty())
+            {
+                size_t left = next() % naive.size();
+                size_t right = left + next() % (naive.size() - left + 1);
+                right = std::min(right, left + 4);
+                naive.erase(naive.begin() + left, naive.begin() + right);
+                tree.EraseRange(left, right);
+            }
+            break;
+        case 3:
+            if (!naive.empty())
+            {
+                naive.pop_back();
+                tree.PopBack();
+            }
+            break;
+        case 4:
+        {
+            size_t index = next() % (naive.size() + 1);
+            std::vector<int> values(next() % 6);
+            for (int& value : values)
+            {
+                value = next() % 100;
+            }
+            naive.insert(naive.begin() + index, values.begin(), values.end());
+            tree.InsertRange(index, values);
+            break;
+        }
+        }
+
+        REQUIRE_EQ(tree.GetCount(), naive.size());
+
+        if (!naive.empty())
+        {
+            size_t left = next() % naive.size();
+            size_t right = left + 1 + next() % (naive.size() - left);
+
+            int expected = 0;
+            for (size_t i = left; i < right; ++i)
+            {
+                expected += naive[i];
+            }
+
+            REQUIRE_EQ(tree.Query(left, right), expected);
+        }
+    }
+}
+
+TEST_CASE("Memory options")
+{
+    for (MemoryOptions memory : { MemoryOptions{ PageMode::Transparent, NumaPolicy::Default },
+                                  MemoryOptions{ PageMode::Explicit, NumaPolicy::Default },
+                                  MemoryOptions{ PageMode::Default, NumaPolicy::Interleave },
+                                  MemoryOptions{ PageMode::Transparent, NumaPolicy::Interleave } })
+    {
+        int data[5] = { 5, 8, 4, 3, 7 };
+        SegmentTree<int> tree{ data, Combine, 0, memory };
+
+        REQUIRE_EQ(tree.GetMemoryOptions().pages, memory.pages);
+        REQUIRE_EQ(tree.Query(0, 5), 27);
+
+        // Huge page backed arrays are aligned to a huge page
+        if (memory.pages != PageMode::Default)
+        {
+            REQUIRE_EQ(uintptr_t(tree.GetTree()) % hugePageSize, 0);
+        }
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            tree.PushBack(1);
+        }
+
+        REQUIRE_EQ(tree.Query(0, tree.GetCount()), 1027);
+
+        SegmentTree<int> copy{ tree };
+        REQUIRE_EQ(copy.GetMemoryOptions().numa, memory.numa);
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            copy.PopBack();
+        }
+
+        REQUIRE_EQ(copy.Query(0, 5), 27);
+        REQUIRE_EQ(tree.Query(0, tree.GetCount()), 1027);
+    }
+}
+
+TEST_CASE("Prefetch")
+{
+    std::vector<int> data(100000);
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = int(i % 97);
+    }
+
+    SegmentTree<int> tree{ data, Combine, 0 };
+    SegmentTree<int> prefetched{ data, Combine, 0 };
+    prefetched.EnablePrefetch();
+
+    REQUIRE_EQ(uintptr_t(tree.GetTree()) % cacheLineSize, 0);
+
+    uint32_t seed = 7;
+    auto next = [&]() {
+        seed = seed * 1664525u + 1013904223u;
+        return size_t(seed >> 8);
+    };
+
+    for (int step = 0; step < 1000; ++step)
+    {
+        size_t index = next() % data.size();
+        int value = int(next() % 1000);
+
+        tree.Update(index, value);
+        prefetched.Update(index, value);
+
+        size_t a = next() % data.size();
+        size_t b = next() % data.size();
+        size_t left = std::min(a, b);
+        size_t right = std::max(a, b) + 1;
+
+        REQUIRE_EQ(prefetched.Query(left, right), tree.Query(left, right));
+    }
+
+    // Small trees lie entirely inside the hot top
+    SegmentTree<int> small{ { 5, 8, 4 }, Combine, 0 };
+    small.EnablePrefetch();
+    small.Update(1, 2);
+
+    REQUIRE_EQ(small.Query(0, 3), 11);
+}
+
+struct Histogram
+{
+    int64_t bins[64];
+};
+
+static void AddInto(Histogram& out, const Histogram& a, const Histogram& b)
+{
+    for (int i = 0; i < 64; ++i)
+    {
+        out.bins[i] = a.bins[i] + b.bins[i];
+    }
+}
+
+// Reads both operands before writing, since out may alias either of them
+static void ComposeInto(Affine& out, const Affine& f, const Affine& g)
+{
+    int a = f.a * g.a % 1009;
+    int b = (f.b * g.a + g.b) % 1009;
+    out.a = a;
+    out.b = b;
+}
+
+TEST_CASE("Combine into")
+{
+    std::vector<Histogram> data(50);
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        for (int j = 0; j < 64; ++j)
+        {
+            data[i].bins[j] = int64_t(i * 64 + j);
+        }
+    }
+
+    SegmentTree<Histogram> tree{ data, AddInto, Histogram{} };
+
+    Histogram sum = tree.Query(3, 17);
+    for (int j = 0; j < 64; ++j)
+    {
+        int64_t expected = 0;
+        for (size_t i = 3; i < 17; ++i)
+        {
+            expected += data[i].bins[j];
+        }
+
+        REQUIRE_EQ(sum.bins[j], expected);
+    }
+
+    tree.Update(5, Histogram{});
+    tree.PushBack(data[0]);
+
+    REQUIRE_EQ(tree.Query(0, 51).bins[0], tree.Query(0, 50).bins[0] + data[0].bins[0]);
+    REQUIRE_EQ(tree.Query(5, 6).bins[63], 0);
+}
+
+TEST_CASE("Combine into matches combine")
+{
+    std::vector<Affine> data;
+    for (int i = 0; i < 40; ++i)
+    {
+        data.push_back(Affine{ i % 7 + 2, i * 5 + 3 });
+    }
+
+    SegmentTree<Affine> tree{ data, Compose, Affine{ 1, 0 } };
+    SegmentTree<Affine> treeInto{ data, ComposeInto, Affine{ 1, 0 } };
+
+    uint32_t seed = 3;
+    auto next = [&]() {
+        seed = seed * 1664525u + 1013904223u;
+        return size_t(seed >> 8);
+    };
+
+    for (int step = 0; step < 300; ++step)
+    {
+        switch (next() % 3)
+        {
+        case 0:
+        {
+            Affine value{ int(next() % 1009), int(next() % 1009) };
+            size_t index = next() % tree.GetCount();
+            tree.Update(index, value);
+            treeInto.Update(index, value);
+            break;
+        }
+        case 1:
+        {
+            Affine value{ int(next() % 1009), int(next() % 1009) };
+            size_t index = next() % (tree.GetCount() + 1);
+            tree.Insert(index, value);
+            treeInto.Insert(index, value);
+            break;
+        }
+        default:
+            if (tree.GetCount() > 1)
+            {
+                size_t index = next() % tree.GetCount();
+                tree.Erase(index);
+                treeInto.Erase(index);
+            }
+            break;
+        }
+
+        size_t a = next() % tree.GetCount();
+        size_t b = next() % tree.GetCount();
+        size_t left = std::min(a, b);
+        size_t right = std::max(a, b) + 1;
+
+        REQUIRE_EQ(treeInto.Query(left, right), tree.Query(left, right));
+        REQUIRE_EQ(treeInto.PrefixQuery(right), tree.PrefixQuery(right));
+        REQUIRE_EQ(treeInto.SuffixQuery(left), tree.SuffixQuery(left));
+    }
+}
+
+int Xor(int a, int b)
+{
+    return a ^ b;
+}
+
+TEST_CASE("Add")
+{
+    int data[7] = { 5, 8, 4, 3, 7, 2, 1 };
+    SegmentTree<int> tree{ data, Combine, 0 };
+
+    tree.Add(2, 10);
+    tree.Add(6, -1);
+
+    REQUIRE_EQ(tree[2], 14);
+    REQUIRE_EQ(tree[6], 0);
+    REQUIRE_EQ(tree.Query(0, 7), 39);
+    REQUIRE_EQ(tree.Query(1, 3), 22);
+    REQUIRE_EQ(tree.GetTree()[1], 39);
+
+    // A zero delta stops at the leaf's parent
+    tree.Add(4, 0);
+    REQUIRE_EQ(tree.Query(4, 5), 7);
+}
+
+TEST_CASE("Update through inverse")
+{
+    std::vector<int> data(100);
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = int(i * 37 % 101);
+    }
+
+    SegmentTree<int> sum{ data, Combine, 0 };
+    SegmentTree<int> sumDelta{ data, Combine, 0 };
+    sumDelta.SetInverse(Subtract);
+
+    SegmentTree<int> xorTree{ data, Xor, 0 };
+    SegmentTree<int> xorDelta{ data, Xor, 0 };
+    xorDelta.SetInverse(Xor);
+
+    uint32_t seed = 11;
+    auto next = [&]() {
+        seed = seed * 1664525u + 1013904223u;
+        return size_t(seed >> 8);
+    };
+
+    for (int step = 0; step < 500; ++step)
+    {
+        size_t index = next() % data.size();
+        int value = int(next() % 1000);
+
+        if (step % 2 == 0)
+        {
+            sum.Update(index, value);
+            sumDelta.Update(index, value);
+            xorTree.Update(index, value);
+            xorDelta.Update(index, value);
+        }
+        else
+        {
+            sum.Update(index, sum[index] + value);
+            sumDelta.Add(index, value);
+            xorTree.Update(index, xorTree[index] ^ value);
+            xorDelta.Add(index, value);
+        }
+
+        size_t a = next() % data.size();
+        size_t b = next() % data.size();
+        size_t left = std::min(a, b);
+        size_t right = std::max(a, b) + 1;
+
+        REQUIRE_EQ(sumDelta.Query(left, right), sum.Query(left, right));
+        REQUIRE_EQ(xorDelta.Query(left, right), xorTree.Query(left, right));
+    }
+
+    for (size_t i = 1; i < sum.GetTreeSize(); ++i)
+    {
+        if (IsStored(sum, i))
+        {
+            REQUIRE_EQ(sumDelta.GetTree()[i], sum.GetTree()[i]);
+            REQUIRE_EQ(xorDelta.GetTree()[i], xorTree.GetTree()[i]);
+        }
+    }
+}
+
+std::string Concat(std::string a, std::string b)
+{
+    return a + b;
+}
+
+TEST_CASE("String")
+{
+    std::vector<std::string> data{ "a", "b", "c", "d", "e" };
+    SegmentTree<std::string> tree{ data, Concat, "" };
+
+    REQUIRE_EQ(tree.Query(0, 5), "abcde");
+    REQUIRE_EQ(tree.Query(1, 4), "bcd");
+
+    std::string value = "long string that does not fit the small buffer";
+    tree.Update(2, std::move(value));
+    tree.Emplace(4, 3, 'x');
+
+    REQUIRE_EQ(tree.Query(1, 5), "blong string that does not fit the small bufferdxxx");
+
+    for (int i = 0; i < 20; ++i)
+    {
+        tree.PushBack(std::to_string(i % 10));
+    }
+
+    tree.Insert(0, "<");
+    tree.Erase(3);
+    tree.EraseRange(5, 15);
+
+    SegmentTree<std::string> copy{ tree };
+    tree.PopBack();
+
+    REQUIRE_EQ(tree.Query(0, tree.GetCount()), "<abdxxx012345678");
+    REQUIRE_EQ(copy.Query(0, copy.GetCount()), "<abdxxx0123456789");
+}
+
+TEST_CASE("String empty insert range")
+{
+    std::vector<std::string> data{ "a", "b", "c" };
+    SegmentTree<std::string> tree{ data, Concat, "" };
+
+    // Full, so the empty run takes the path that shifts in place
+    tree.InsertRange(0, std::span<const std::string>{});
+
+    REQUIRE_EQ(tree.GetCount(), 3);
+    REQUIRE_EQ(tree[0], "a");
+    REQUIRE_EQ(tree.Query(0, 3), "abc");
+
+    tree.Reserve(8);
+    tree.InsertRange(1, std::span<const std::string>{});
+
+    REQUIRE_EQ(tree.GetCount(), 3);
+    REQUIRE_EQ(tree[2], "c");
+    REQUIRE_EQ(tree.Query(0, 3), "abc");
+}
+
+TEST_CASE("Implicit padding")
+{
+    // Just past a power of two, only the stored leaves are allocated
+    std::vector<std::string> data(17, "x");
+    SegmentTree<std::string> tree{ data, Concat, "" };
+
+    REQUIRE_EQ(tree.GetTreeSize(), 64);
+    REQUIRE_EQ(tree.GetCapacity(), 17);
+
+    std::vector<std::string> reference = data;
+
+    uint32_t seed = 5;
+    auto next = [&]() {
+        seed = seed * 1664525u + 1013904223u;
+        return size_t(seed >> 8);
+    };
+
+    for (int step = 0; step < 400; ++step)
+    {
+        std::string value(1, char('a' + step % 26));
+
+        switch (next() % 5)
+        {
+        case 0:
+            tree.PushBack(value);
+            reference.push_back(value);
+            break;
+        case 1:
+        {
+            size_t index = next() % (reference.size() + 1);
+            tree.Insert(index, value);
+            reference.insert(reference.begin() + index, value);
+            break;
+        }
+        case 2:
+            if (!reference.empty())
+            {
+                tree.PopBack();
+                reference.pop_back();
+            }
+            break;
+        case 3:
+            if (!reference.empty())
+            {
+                size_t left = next() % reference.size();
+                size_t right = std::min(reference.size(), left + next() % 4);
+                tree.EraseRange(left, right);
+                reference.erase(reference.begin() + left, reference.begin() + right);
+            }
+            break;
+        default:
+            if (!reference.empty())
+            {
+                size_t index = next() % reference.size();
+                tree.Update(index, value);
+                reference[index] = value;
+            }
+            break;
+        }
+
+        REQUIRE_EQ(tree.GetCount(), reference.size());
+        REQUIRE_LE(tree.GetCapacity(), tree.GetTreeSize() / 2);
+
+        std::string all;
+        for (const std::string& s : reference)
+        {
+            all += s;
+        }
+
+        REQUIRE_EQ(tree.PrefixQuery(reference.size()), all);
+        REQUIRE_EQ(tree.SuffixQuery(0), all);
+
+        if (!reference.empty())
+        {
+            size_t a = next() % reference.size();
+            size_t b = next() % reference.size();
+            size_t left = std::min(a, b);
+            size_t right = std::max(a, b) + 1;
+
+            std::string expected;
+            for (size_t i = left; i < right; ++i)
+            {
+                expected += reference[i];
+            }
+
+            REQUIRE_EQ(tree.Query(left, right), expected);
+            REQUIRE_EQ(tree.SuffixQuery(left), all.substr(left));
+            REQUIRE_EQ(tree.PrefixQuery(right), all.substr(0, right));
+        }
+    }
+
+    tree.ShrinkToFit();
+
+    REQUIRE_EQ(tree.GetCapacity(), tree.GetCount());
+}
+
+// Counts constructions and copies, to check that the tree never default constructs and moves where it can
+struct Tracked
+{
+    static inline int defaults = 0;
+    static inline int copies = 0;
+
+    std::vector<int> values;
+
+    Tracked()
+    {
+        ++defaults;
+    }
+
+    Tracked(std::vector<int> values)
+        : values{ std::move(values) }
+    {
+    }
+
+    Tracked(const Tracked& other)
+        : values{ other.values }
+    {
+        ++copies;
+    }
+
+    Tracked(Tracked&&) noexcept = default;
+
+    Tracked& operator=(const Tracked& other)
+    {
+        values = other.values;
+        ++copies;
+        return *this;
+    }
+
+    Tracked& operator=(Tracked&&) noexcept = default;
+};
+
+// Merge sort tree node, every node holds the sorted elements of its range
+void MergeSorted(Tracked& out, const Tracked& a, const Tracked& b)
+{
+    std::vector<int> merged(a.values.size() + b.values.size());
+    std::merge(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(), merged.begin());
+    out.values = std::move(merged);
+}
+
+TEST_CASE("Non-trivial storage")
+{
+    std::vector<Tracked> data;
+    for (int v : { 5, 8, 4, 3, 7, 2 })
+    {
+        data.push_back(Tracked{ std::vector<int>{ v } });
+    }
+
+    Tracked::defaults = 0;
+    Tracked::copies = 0;
+
+    SegmentTree<Tracked> tree{ data, MergeSorted, Tracked{ {} } };
+
+    REQUIRE_EQ(Tracked::defaults, 0);
+    REQUIRE(tree.Query(1, 5).values == std::vector<int>{ 3, 4, 7, 8 });
+
+    int copies = Tracked::copies;
+    tree.PushBack(Tracked{ { 1 } });
+    tree.PushBack(Tracked{ { 10 } });
+
+    // The first push only adds leaf slots, which moves the stored nodes,
+    // then the node above only the new leaf is constructed as a copy of it
+    REQUIRE_EQ(Tracked::copies - copies, 1);
+
+    // Growth moves the existing leaves, then copies noneValue into the 11 stored internal nodes
+    // before the in-place combine fills them, the padding is not written
+    copies = Tracked::copies;
+    tree.Insert(0, Tracked{ { 9 } });
+
+    REQUIRE_EQ(Tracked::defaults, 0);
+    REQUIRE_EQ(Tracked::copies - copies, 11);
+
+    copies = Tracked::copies;
+    tree.Update(3, Tracked{ { 6 } });
+    tree.Emplace(0, std::vector<int>{ 0 });
+    tree.Erase(1);
+
+    // Nothing is padded, so nothing is copied
+    REQUIRE_EQ(Tracked::copies - copies, 0);
+    REQUIRE_EQ(tree.GetCount(), 8);
+    REQUIRE(tree.Query(0, 8).values == std::vector<int>{ 0, 1, 2, 3, 6, 7, 8, 10 });
+}
@@ -0,0 +1,115 @@
+#include "doctest.h"
+#include "segment_tree/veb_segment_tree.h"
+
+#include <functional>
+#include <vector>
+
+using VebSumTree = VebSegmentTree<int, std::plus<>>;
+
+static int Sum(int a, int b)
+{
+    return a + b;
+}
+
+TEST_CASE("Veb layout")
+{
+    std::vector<int> data{ 5, 8, 4, 3, 7, 2, 1 };
+    VebSumTree tree{ data, 0 };
+
+    REQUIRE_EQ(tree.GetTreeSize(), 16);
+    REQUIRE_EQ(tree.GetNoneValue(), 0);
+
+    // Height 4 splits into a top tree of nodes 1..3 and four bottom trees of three nodes each
+    std::vector<size_t> order{ 1, 2, 3, 4, 8, 9, 5, 10, 11, 6, 12, 13, 7, 14, 15 };
+    for (size_t position = 1; position < 16; ++position)
+    {
+        REQUIRE_EQ(tree.GetPosition(order[position - 1]), position);
+    }
+
+    REQUIRE_EQ(tree.GetTree()[1], 30);
+    REQUIRE_EQ(tree.GetTree()[4], 13);
+    REQUIRE_EQ(tree.GetTree()[5], 5);
+    REQUIRE_EQ(tree.GetTree()[15], 0);
+
+    REQUIRE_EQ(tree.Query(2, 6), 16);
+    REQUIRE_EQ(tree.Query(0, 7), 30);
+
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        REQUIRE_EQ(tree[i], data[i]);
+    }
+}
+
+TEST_CASE("Veb positions are a permutation")
+{
+    for (size_t n : { size_t(1), size_t(2), size_t(3), size_t(100), size_t(1000) })
+    {
+        std::vector<int> data(n, 1);
+        VebSumTree tree{ data, 0 };
+
+        std::vector<bool> seen(tree.GetTreeSize(), false);
+        for (size_t i = 1; i < tree.GetTreeSize(); ++i)
+        {
+            size_t position = tree.GetPosition(i);
+            REQUIRE(position > 0);
+            REQUIRE(position < tree.GetTreeSize());
+            REQUIRE_FALSE(seen[position]);
+            seen[position] = true;
+        }
+
+        REQUIRE_EQ(tree.GetTree()[1], int(n));
+    }
+}
+
+TEST_CASE("Veb matches segment tree")
+{
+    for (size_t n : { size_t(1), size_t(2), size_t(31), size_t(64), size_t(100), size_t(257) })
+    {
+        std::vector<int> data(n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            data[i] = int(i * 7919 % 101);
+        }
+
+        VebSumTree tree{ data, 0 };
+        SegmentTree<int> reference{ data, Sum, 0 };
+
+        for (size_t i = 0; i < n; i += 3)
+        {
+            tree.Update(i, int(i % 17));
+            reference.Update(i, int(i % 17));
+        }
+
+        for (size_t left = 0; left < n; ++left)
+        {
+            for (size_t right = left + 1; right <= n; ++right)
+            {
+                REQUIRE_EQ(tree.Query(left, right), reference.Query(left, right));
+            }
+
+            REQUIRE_EQ(tree[left], reference[left]);
+        }
+    }
+}
+
+TEST_CASE("Veb copy and move")
+{
+    std::vector<int> data{ 1, 2, 3, 4, 5 };
+    VebSumTree tree{ data, 0 };
+
+    VebSumTree copy{ tree };
+    copy.Update(0, 10);
+
+    REQUIRE_EQ(tree.Query(0, 5), 15);
+    REQUIRE_EQ(copy.Query(0, 5), 24);
+
+    VebSumTree moved{ std::move(copy) };
+    REQUIRE_EQ(moved.Query(0, 5), 24);
+    REQUIRE_EQ(copy.GetTree(), nullptr);
+
+    tree = moved;
+    REQUIRE_EQ(tree.Query(1, 5), 14);
+
+    moved = VebSumTree{ data, 0 };
+    REQUIRE_EQ(moved.Query(0, 5), 15);
+}